@@ -1,41 +1,243 @@
 #include "ArtManager.h"
+#include "Components/Logger.h"
+#include "ThumbnailService.h"
 
+#include <QCoreApplication>
 #include <QDirIterator>
-#include <QPixmapCache>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
 
-QHash<QString, QIcon> ArtManager::icons;
+#include <iterator>
+
+// Icons of image files are thumbnails this big, which is as large as any view shows them (the subimage list).
+static const QSize kIconThumbnailSize(64, 64);
+
+// How long an unreadable image is taken at its word before its file is checked for changes.
+static constexpr int kUnreadableRecheckMs = 2000;
+
+// Bookkeeping charged to every cached image on top of its pixels, so that entries without any still count.
+static constexpr qint64 kImageEntryOverhead = 128;
+
+QHash<QString, QIcon> ArtManager::builtinIcons;
+QHash<QString, ArtManager::CachedIcon> ArtManager::projectIcons;
+QHash<QString, ArtManager::CachedPixmap> ArtManager::projectPixmaps;
+std::list<ArtManager::CachedImage> ArtManager::recentImages;
+qint64 ArtManager::imageCacheBudget = 0;
+ImageCacheCounters ArtManager::imageCacheCounters;
+QSet<QString> ArtManager::loading;
+QHash<QString, ArtManager::PendingPixmap> ArtManager::decodingPixmaps;
+QHash<QString, ArtManager::UnreadablePixmap> ArtManager::unreadablePixmaps;
+ArtManager::DeferredLoads* ArtManager::deferredLoads = nullptr;
 QBrush ArtManager::transparenyBrush;
 
-void ArtManager::Init() {
+ArtManager::DeferredLoads::DeferredLoads() : outer_(ArtManager::deferredLoads) { ArtManager::deferredLoads = this; }
+
+ArtManager::DeferredLoads::~DeferredLoads() {
+  ArtManager::deferredLoads = outer_;
+  if (outer_) outer_->pending_ += pending_;
+}
+
+void ArtManager::Init(qint64 cacheBudget) {
+  imageCacheBudget = cacheBudget;
+
   QDirIterator it(":/resources", QDirIterator::Subdirectories);
   while (it.hasNext()) {
     QString path = it.next();
     QString name = path.mid(path.lastIndexOf("/") + 1, path.lastIndexOf(".") - 1 - path.lastIndexOf("/"));
-    icons[name] = QIcon(path);
+    builtinIcons[name] = QIcon(path);
   }
 
   transparenyBrush = QBrush(Qt::black, QPixmap(":/transparent.png"));
 
-  QPixmapCache::setCacheLimit(500000);  // 500mb cache limit
+  QObject::connect(ThumbnailService::Instance(), &ThumbnailService::ThumbnailReady, Loader(), &ThumbnailReady);
 }
 
 ArtManager::ArtManager() {}
 
-const QIcon& ArtManager::GetIcon(const QString& name) {
-  if (!icons.contains(name)) icons[name] = QIcon(name);
+QIcon ArtManager::GetIcon(const QString& name) {
+  if (auto icon = builtinIcons.find(name); icon != builtinIcons.end()) return *icon;
+  // Built-in art is compiled in and small, so it is pinned rather than budgeted.
+  if (name.startsWith(':')) return builtinIcons[name] = QIcon(name);
+
+  if (auto cached = projectIcons.find(name); cached != projectIcons.end()) {
+    ++imageCacheCounters.hits;
+    recentImages.splice(recentImages.begin(), recentImages, cached->use);
+    return cached->icon;
+  }
+  ++imageCacheCounters.misses;
+  if (deferredLoads) {
+    // The thumbnail service keeps nothing in memory; what it makes is cached here, under the budget.
+    ThumbnailService::Instance()->Request(name, kIconThumbnailSize);
+    deferredLoads->pending_.append(name);
+    loading.insert(name);
+    return Placeholder();
+  }
+  // Whole images kept as icons add up to gigabytes over a long session, and nothing shows an icon bigger than this.
+  QPixmap pixmap(name);
+  if (pixmap.width() > kIconThumbnailSize.width() || pixmap.height() > kIconThumbnailSize.height()) {
+    pixmap = pixmap.scaled(kIconThumbnailSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+  }
+  return CacheIcon(name, pixmap);
+}
+
+qint64 ArtManager::ImageBytes(const QString& name, const QPixmap& pixmap) {
+  return kImageEntryOverhead + name.size() * qint64(sizeof(QChar)) +
+         qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+}
+
+QIcon ArtManager::CacheIcon(const QString& name, const QPixmap& pixmap) {
+  if (auto old = projectIcons.find(name); old != projectIcons.end()) Evict(old->use);
+  const qint64 bytes = ImageBytes(name, pixmap);
+  const QIcon icon = pixmap.isNull() ? QIcon() : QIcon(pixmap);
+  recentImages.push_front({true, name});
+  projectIcons.insert(name, {icon, bytes, recentImages.begin()});
+  imageCacheCounters.bytes += bytes;
+  TrimImages();
+  return icon;
+}
+
+bool ArtManager::FindPixmap(const QString& name, QPixmap* pixmap) {
+  auto cached = projectPixmaps.find(name);
+  if (cached == projectPixmaps.end()) return false;
+  ++imageCacheCounters.hits;
+  recentImages.splice(recentImages.begin(), recentImages, cached->use);
+  *pixmap = cached->pixmap;
+  return true;
+}
+
+void ArtManager::CachePixmap(const QString& name, const QPixmap& pixmap) {
+  if (auto old = projectPixmaps.find(name); old != projectPixmaps.end()) Evict(old->use);
+  const qint64 bytes = ImageBytes(name, pixmap);
+  recentImages.push_front({false, name});
+  projectPixmaps.insert(name, {pixmap, bytes, recentImages.begin()});
+  imageCacheCounters.bytes += bytes;
+  TrimImages();
+}
+
+void ArtManager::Evict(std::list<CachedImage>::iterator use) {
+  if (use->icon) imageCacheCounters.bytes -= projectIcons.take(use->name).bytes;
+  else imageCacheCounters.bytes -= projectPixmaps.take(use->name).bytes;
+  recentImages.erase(use);
+}
+
+void ArtManager::TrimImages() {
+  // The most recent image stays even if it alone is over budget; whoever asked for it is about to use it.
+  while (imageCacheCounters.bytes > imageCacheBudget && recentImages.size() > 1) {
+    Evict(std::prev(recentImages.end()));
+    ++imageCacheCounters.evictions;
+  }
+}
+
+void ArtManager::SetImageCacheBudget(qint64 bytes) {
+  imageCacheBudget = bytes;
+  TrimImages();
+}
+
+const ImageCacheCounters& ArtManager::ImageCacheStats() { return imageCacheCounters; }
+
+const QIcon& ArtManager::Placeholder() {
+  static const QIcon placeholder = []() {
+    QPixmap blank(16, 16);
+    blank.fill(Qt::transparent);
+    return QIcon(blank);
+  }();
+  return placeholder;
+}
+
+ArtLoader* ArtManager::Loader() {
+  static ArtLoader* const loader = new ArtLoader();
+  return loader;
+}
 
-  return icons[name];
+void ArtManager::ThumbnailReady(const QString& path, const QSize& size, const QPixmap& thumbnail) {
+  if (size != kIconThumbnailSize || !loading.remove(path)) return;
+  CacheIcon(path, thumbnail);
+  emit Loader()->IconLoaded(path);
 }
 
 const QBrush& ArtManager::GetTransparenyBrush() { return transparenyBrush; }
 
-const QPixmap& ArtManager::GetCachedPixmap(const QString& name) {
-  static QPixmap pm;
-  if (!QPixmapCache::find(name, &pm)) {
-    pm.load(name);
-    QPixmapCache::insert(name, pm);
+static QImage DecodeImage(const QString& name) { return QImage(name); }
+
+QPixmap ArtManager::GetCachedPixmap(const QString& name) {
+  R_EXPECT(QThread::currentThread() == QCoreApplication::instance()->thread(), QPixmap())
+      << "Pixmaps can only be made on the GUI thread; decode" << name << "into a QImage instead";
+  QPixmap pixmap;
+  if (FindPixmap(name, &pixmap) || IsUnreadable(name)) return pixmap;
+  ++imageCacheCounters.misses;
+  // If it's already being decoded in the background, wait for that rather than decoding it twice.
+  if (auto pending = decodingPixmaps.find(name); pending != decodingPixmaps.end()) {
+    return PixmapDecoded(name, pending->batch.resultAt(pending->index));
+  }
+  return PixmapDecoded(name, DecodeImage(name));
+}
+
+QPixmap ArtManager::FindCachedPixmap(const QString& name) {
+  QPixmap pixmap;
+  if (FindPixmap(name, &pixmap) || IsUnreadable(name)) return pixmap;
+  if (!decodingPixmaps.contains(name)) ++imageCacheCounters.misses;
+  PrefetchPixmaps({name});
+  return pixmap;
+}
+
+QFuture<void> ArtManager::PrefetchPixmaps(const QStringList& names) {
+  QStringList missing;
+  for (const QString& name : names) {
+    if (decodingPixmaps.contains(name) || IsUnreadable(name) || projectPixmaps.contains(name)) continue;
+    decodingPixmaps.insert(name, {});
+    missing.append(name);
+  }
+  if (missing.isEmpty()) return {};
+
+  const QFuture<QImage> batch = QtConcurrent::mapped(missing, DecodeImage);
+  for (int i = 0; i < missing.size(); ++i) decodingPixmaps[missing[i]] = {batch, i};
+
+  auto* watcher = new QFutureWatcher<QImage>(Loader());
+  QObject::connect(watcher, &QFutureWatcher<QImage>::resultReadyAt, Loader(), [watcher, missing](int i) {
+    // GetCachedPixmap may have collected it already, or the project may have been closed since.
+    auto pending = decodingPixmaps.find(missing[i]);
+    if (pending == decodingPixmaps.end() || pending->batch != watcher->future()) return;
+    PixmapDecoded(missing[i], watcher->resultAt(i));
+  });
+  QObject::connect(watcher, &QFutureWatcher<QImage>::finished, watcher, &QObject::deleteLater);
+  watcher->setFuture(batch);
+  return batch;
+}
+
+bool ArtManager::IsUnreadable(const QString& name) {
+  auto unreadable = unreadablePixmaps.find(name);
+  if (unreadable == unreadablePixmaps.end()) return false;
+  if (!unreadable->recheck.hasExpired()) return true;
+  // A file that was missing or still being written when it was read gets a new modification time once it's done.
+  if (QFileInfo(name).lastModified() == unreadable->modified) {
+    unreadable->recheck.setRemainingTime(kUnreadableRecheckMs);
+    return true;
+  }
+  unreadablePixmaps.erase(unreadable);
+  return false;
+}
+
+QPixmap ArtManager::PixmapDecoded(const QString& name, const QImage& image) {
+  decodingPixmaps.remove(name);
+  const QPixmap pixmap = QPixmap::fromImage(image);
+  if (pixmap.isNull()) {
+    unreadablePixmaps.insert(name, {QFileInfo(name).lastModified(), QDeadlineTimer(kUnreadableRecheckMs)});
+  } else {
+    CachePixmap(name, pixmap);
   }
-  return std::move(pm);
+  emit Loader()->PixmapLoaded(name);
+  return pixmap;
 }
 
-void ArtManager::clearCache() { QPixmapCache::clear(); }
+void ArtManager::clearCache() {
+  decodingPixmaps.clear();
+  unreadablePixmaps.clear();
+  projectIcons.clear();
+  projectPixmaps.clear();
+  recentImages.clear();
+  // Thumbnails still in flight belong to the old project; ThumbnailReady drops whatever it no longer waits for.
+  loading.clear();
+  imageCacheCounters.bytes = 0;
+}
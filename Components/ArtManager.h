@@ -2,20 +2,137 @@
 #define ARTMANAGER_H
 
 #include <QBrush>
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QFuture>
 #include <QHash>
 #include <QIcon>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QSet>
+#include <QStringList>
+
+#include <list>
+
+// Announces icons and pixmaps which ArtManager finished loading in the background.
+class ArtLoader : public QObject {
+  Q_OBJECT
+
+ signals:
+  void IconLoaded(const QString& name);
+  void PixmapLoaded(const QString& name);
+};
+
+// Running totals of ArtManager's cache of project images, icons and full pixmaps alike. Built-in art is pinned and
+// isn't counted.
+struct ImageCacheCounters {
+  quint64 hits = 0;       ///< Lookups answered from the cache.
+  quint64 misses = 0;     ///< Lookups which had to load the image, or start loading it.
+  quint64 evictions = 0;  ///< Icons and pixmaps dropped, least recently used first, to stay within the budget.
+  qint64 bytes = 0;       ///< Estimated memory held by the icons and pixmaps cached right now.
+};
 
 class ArtManager {
  public:
-  static void Init();
-  static const QIcon& GetIcon(const QString& name);
+  // While one of these is alive (on the GUI thread), GetIcon doesn't decode image files on the spot. It asks
+  // ThumbnailService for them and hands out Placeholder() instead; Loader() announces each icon once it is ready.
+  class DeferredLoads {
+   public:
+    DeferredLoads();
+    ~DeferredLoads();
+    DeferredLoads(const DeferredLoads&) = delete;
+    DeferredLoads& operator=(const DeferredLoads&) = delete;
+
+    // The icons this scope (or any scope nested in it) got a placeholder for.
+    const QStringList& Pending() const { return pending_; }
+
+   private:
+    friend class ArtManager;
+    DeferredLoads* outer_;
+    QStringList pending_;
+  };
+
+  // Loads the built-in art and caps the memory held by project images at `cacheBudget` bytes.
+  static void Init(qint64 cacheBudget);
+  // Returns the named built-in icon, or an icon of the image file at the given path.
+  static QIcon GetIcon(const QString& name);
+  // A blank icon, standing in for one that is still loading.
+  static const QIcon& Placeholder();
+  static ArtLoader* Loader();
   static const QBrush& GetTransparenyBrush();
-  static const QPixmap& GetCachedPixmap(const QString& name);
+  // Returns the image file as a pixmap, decoding it now if it isn't cached. The pixmap shares its data with the cached
+  // copy, which is never modified; drawing into it detaches the caller's copy. GUI thread only, like QPixmap itself.
+  static QPixmap GetCachedPixmap(const QString& name);
+  // Returns the cached pixmap of the image file without ever touching the disk, so paint code can call it. On a miss
+  // it returns a null pixmap and starts decoding the image in the background; Loader() announces it with PixmapLoaded.
+  static QPixmap FindCachedPixmap(const QString& name);
+  // Decodes the given images on the thread pool ahead of anyone drawing them. Each is cached, and announced, as soon
+  // as it's ready; the returned future finishes once all of them are decoded.
+  static QFuture<void> PrefetchPixmaps(const QStringList& names);
   static void clearCache();
 
+  // Caps the memory held by icons and pixmaps of project images, evicting the least recently used ones past it.
+  static void SetImageCacheBudget(qint64 bytes);
+  static const ImageCacheCounters& ImageCacheStats();
+
  private:
+  // An entry in the cache of project images. Icons and pixmaps of the same image are cached apart, but share a budget
+  // and are evicted in the order they were last used.
+  struct CachedImage {
+    bool icon;
+    QString name;
+  };
+
+  struct CachedIcon {
+    QIcon icon;
+    qint64 bytes;
+    std::list<CachedImage>::iterator use;  // Position in recentImages.
+  };
+
+  struct CachedPixmap {
+    QPixmap pixmap;
+    qint64 bytes;
+    std::list<CachedImage>::iterator use;  // Position in recentImages.
+  };
+
+  // An image being decoded in the background: result `index` of the batch started by PrefetchPixmaps.
+  struct PendingPixmap {
+    QFuture<QImage> batch;
+    int index;
+  };
+
+  // An image which couldn't be decoded. It is kept so paint code doesn't retry it on every frame, but once in a while
+  // the file is checked again, and retried if it has changed (or appeared) since.
+  struct UnreadablePixmap {
+    QDateTime modified;  // Invalid if the file was missing.
+    QDeadlineTimer recheck;
+  };
+
   ArtManager();
-  static QHash<QString, QIcon> icons;
+  static bool IsUnreadable(const QString& name);
+  // Caches a decoded image as a pixmap, or remembers that it couldn't be read, and announces it.
+  static QPixmap PixmapDecoded(const QString& name, const QImage& image);
+  static void ThumbnailReady(const QString& path, const QSize& size, const QPixmap& thumbnail);
+  // Caches the pixmap as the icon of the named image, and evicts images until the cache fits its budget again.
+  static QIcon CacheIcon(const QString& name, const QPixmap& pixmap);
+  // Finds the cached pixmap of the named image, counting the lookup as a use of it.
+  static bool FindPixmap(const QString& name, QPixmap* pixmap);
+  static void CachePixmap(const QString& name, const QPixmap& pixmap);
+  static qint64 ImageBytes(const QString& name, const QPixmap& pixmap);
+  static void Evict(std::list<CachedImage>::iterator use);
+  static void TrimImages();
+
+  static QHash<QString, QIcon> builtinIcons;
+  static QHash<QString, CachedIcon> projectIcons;
+  static QHash<QString, CachedPixmap> projectPixmaps;
+  static std::list<CachedImage> recentImages;  // Entries of projectIcons and projectPixmaps, most recently used first.
+  static qint64 imageCacheBudget;
+  static ImageCacheCounters imageCacheCounters;
+  static QSet<QString> loading;
+  static QHash<QString, PendingPixmap> decodingPixmaps;
+  static QHash<QString, UnreadablePixmap> unreadablePixmaps;
+  static DeferredLoads* deferredLoads;
   static QBrush transparenyBrush;
 };
 
@@ -0,0 +1,235 @@
+#include "DependencyAnalyzer.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+
+using buffers::TreeNode;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Message;
+
+namespace {
+
+struct Reference {
+  QString field;
+  QString type;
+  QString name;
+};
+
+// Everything about one resource that the graph needs, gathered independently of every other resource.
+struct ResourceFacts {
+  QVector<Reference> references;
+  QSet<QString> identifiers;  // Words in code and other free-form strings that could name a resource.
+  qint64 diskBytes = 0;
+};
+
+void AddIdentifiers(const QString &text, QSet<QString> *identifiers) {
+  int start = -1;
+  for (int i = 0; i <= text.size(); ++i) {
+    const bool word_char = i < text.size() && (text[i].isLetterOrNumber() || text[i] == '_');
+    if (word_char && start < 0) start = i;
+    if (!word_char && start >= 0) {
+      if (!text[start].isDigit()) identifiers->insert(text.mid(start, i - start));
+      start = -1;
+    }
+  }
+}
+
+void Scan(const Message &message, const QString &path, const QDir &directory, ResourceFacts *facts) {
+  const google::protobuf::Reflection *refl = message.GetReflection();
+  std::vector<const FieldDescriptor *> fields;
+  refl->ListFields(message, &fields);
+  for (const FieldDescriptor *field : fields) {
+    const QString name = path + QString::fromStdString(field->name());
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      if (field->is_repeated()) {
+        for (int i = 0; i < refl->FieldSize(message, field); ++i)
+          Scan(refl->GetRepeatedMessage(message, field, i), name + '[' + QString::number(i) + "].", directory, facts);
+      } else {
+        Scan(refl->GetMessage(message, field), name + '.', directory, facts);
+      }
+      continue;
+    }
+    if (field->type() != FieldDescriptor::TYPE_STRING) continue;
+
+    const auto &options = field->options();
+    const QString ref_type = options.HasExtension(buffers::resource_ref)
+                                 ? QString::fromStdString(options.GetExtension(buffers::resource_ref))
+                                 : QString();
+    const bool is_file = options.HasExtension(buffers::file_kind);
+    auto visit = [&](const std::string &value, const QString &where) {
+      if (value.empty()) return;
+      const QString text = QString::fromStdString(value);
+      if (!ref_type.isEmpty()) facts->references.append({where, ref_type, text});
+      else if (is_file) facts->diskBytes += QFileInfo(directory, text).size();
+      else AddIdentifiers(text, &facts->identifiers);
+    };
+    if (field->is_repeated()) {
+      for (int i = 0; i < refl->FieldSize(message, field); ++i)
+        visit(refl->GetRepeatedString(message, field, i), name + '[' + QString::number(i) + ']');
+    } else {
+      visit(refl->GetString(message, field), name);
+    }
+  }
+}
+
+// Relative file paths in the project are relative to the directory of the project file, not to wherever the editor
+// happens to have been started.
+struct ResourceScanner {
+  using result_type = ResourceFacts;
+
+  QDir directory;
+
+  ResourceFacts operator()(const TreeNode *node) const {
+    ResourceFacts facts;
+    const FieldDescriptor *resource =
+        node->GetReflection()->GetOneofFieldDescriptor(*node, TreeNode::descriptor()->FindOneofByName("type"));
+    if (resource && resource->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE)
+      Scan(node->GetReflection()->GetMessage(*node, resource), "", directory, &facts);
+    return facts;
+  }
+};
+
+// resource_ref spells types the way TreeNode names its fields, and TreeNode's type cases are those fields' numbers.
+int TypeNamed(const QString &type) {
+  const FieldDescriptor *field = TreeNode::descriptor()->FindFieldByName(type.toStdString());
+  return field ? field->number() : TreeNode::TYPE_NOT_SET;
+}
+
+}  // namespace
+
+DependencyAnalyzer::DependencyAnalyzer(ProjectSnapshots *snapshots, const QString &project_directory,
+                                       QObject *parent)
+    : QObject(parent), snapshots_(snapshots), project_directory_(project_directory) {
+  connect(&watcher_, &QFutureWatcher<Report>::finished, this, [this]() {
+    if (!watcher_.isCanceled()) emit Finished(watcher_.result());
+  });
+}
+
+void DependencyAnalyzer::Run() {
+  const quint64 version = snapshots_->Version();
+  watcher_.setFuture(
+      QtConcurrent::run(&DependencyAnalyzer::Analyze, snapshots_->Capture(), version, project_directory_));
+}
+
+DependencyAnalyzer::Report DependencyAnalyzer::Analyze(ProjectSnapshots::Snapshot snapshot, quint64 version,
+                                                       const QString &project_directory) {
+  auto report = std::make_shared<DependencyReport>();
+  report->version = version;
+  if (!snapshot) return report;
+
+  QVector<const TreeNode *> resources;
+  resources.reserve(snapshot->size());
+  for (const ProjectSnapshots::Resource &resource : *snapshot) resources.append(resource.get());
+  report->resourceCount = resources.size();
+
+  const QVector<ResourceFacts> facts =
+      QtConcurrent::blockingMapped<QVector<ResourceFacts>>(resources, ResourceScanner{QDir(project_directory)});
+
+  auto describe = [&](int id) -> DependencyReport::Resource {
+    return {resources[id]->type_case(), QString::fromStdString(resources[id]->name()), facts[id].diskBytes};
+  };
+
+  QHash<QPair<int, QString>, int> by_key;
+  QHash<QString, QVector<int>> by_name;
+  for (int id = 0; id < resources.size(); ++id) {
+    const QString name = QString::fromStdString(resources[id]->name());
+    by_key.insert({resources[id]->type_case(), name}, id);
+    by_name[name].append(id);
+  }
+
+  // Edges for reachability cover every mention; the cycle check only cares about resource_ref fields.
+  QVector<QVector<int>> uses(resources.size()), refers(resources.size());
+  for (int id = 0; id < resources.size(); ++id) {
+    for (const Reference &reference : facts[id].references) {
+      const int target = by_key.value({TypeNamed(reference.type), reference.name}, -1);
+      if (target < 0) {
+        report->brokenReferences.append({describe(id), reference.field, reference.type, reference.name});
+        continue;
+      }
+      uses[id].append(target);
+      refers[id].append(target);
+    }
+    for (const QString &identifier : facts[id].identifiers) {
+      for (int target : by_name.value(identifier)) {
+        if (target != id) uses[id].append(target);
+      }
+    }
+  }
+
+  QVector<bool> used(resources.size(), false);
+  QVector<int> queue;
+  for (int id = 0; id < resources.size(); ++id) {
+    const int type = resources[id]->type_case();
+    if (type == TreeNode::kRoom || type == TreeNode::kSettings) {
+      used[id] = true;
+      queue.append(id);
+    }
+  }
+  for (int next = 0; next < queue.size(); ++next) {
+    for (int target : qAsConst(uses[queue[next]])) {
+      if (used[target]) continue;
+      used[target] = true;
+      queue.append(target);
+    }
+  }
+  report->usedCount = queue.size();
+
+  for (int id = 0; id < resources.size(); ++id) {
+    if (used[id]) continue;
+    report->orphans.append(describe(id));
+    report->orphanBytes += facts[id].diskBytes;
+  }
+  std::stable_sort(report->orphans.begin(), report->orphans.end(),
+                   [](const DependencyReport::Resource &a, const DependencyReport::Resource &b) {
+                     return a.diskBytes > b.diskBytes;
+                   });
+
+  // Tarjan's strongly connected components over resource_ref edges. A chain of references can be as long as the
+  // project is big, and this runs on a pool thread with a small stack, so the search keeps its own stack of the
+  // resources being visited, each with the next of its references to follow.
+  QVector<int> index(resources.size(), -1), low(resources.size(), 0), stack;
+  QVector<bool> on_stack(resources.size(), false);
+  QVector<QPair<int, int>> path;
+  int counter = 0;
+  auto enter = [&](int v) {
+    index[v] = low[v] = counter++;
+    stack.append(v);
+    on_stack[v] = true;
+    path.append({v, 0});
+  };
+  for (int root = 0; root < resources.size(); ++root) {
+    if (index[root] >= 0) continue;
+    enter(root);
+    while (!path.isEmpty()) {
+      const int v = path.last().first;
+      if (path.last().second < refers[v].size()) {
+        const int w = refers[v][path.last().second++];
+        if (index[w] < 0) enter(w);
+        else if (on_stack[w]) low[v] = std::min(low[v], index[w]);
+        continue;
+      }
+      path.removeLast();
+      if (!path.isEmpty()) {
+        const int caller = path.last().first;
+        low[caller] = std::min(low[caller], low[v]);
+      }
+      if (low[v] != index[v]) continue;
+      QVector<DependencyReport::Resource> component;
+      int w;
+      do {
+        w = stack.takeLast();
+        on_stack[w] = false;
+        component.append(describe(w));
+      } while (w != v);
+      if (component.size() > 1 || refers[v].contains(v)) report->cycles.append(component);
+    }
+  }
+
+  return report;
+}
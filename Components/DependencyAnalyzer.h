@@ -0,0 +1,64 @@
+#ifndef DEPENDENCYANALYZER_H
+#define DEPENDENCYANALYZER_H
+
+#include "Components/ProjectSnapshots.h"
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QVector>
+
+#include <memory>
+
+// What a project actually uses. Rooms and game settings are the roots; a resource is used if a used resource refers to
+// it, either through a resource_ref field or by naming it in code (or any other string field).
+struct DependencyReport {
+  struct Resource {
+    int type;          // TreeNode type case.
+    QString name;
+    qint64 diskBytes;  // Total size of the files the resource points at through file_kind fields.
+  };
+  struct BrokenReference {
+    Resource from;
+    QString field;       // Path of the resource_ref field within the referring resource.
+    QString targetType;  // As spelled in resource_ref.
+    QString targetName;
+  };
+
+  quint64 version = 0;  // Snapshot version the report was computed from.
+  int resourceCount = 0;
+  int usedCount = 0;
+  QVector<Resource> orphans;  // Largest first.
+  qint64 orphanBytes = 0;
+  QVector<BrokenReference> brokenReferences;
+  // Groups of resources that refer to each other in a loop through resource_ref fields, e.g. objects that are each
+  // other's parents.
+  QVector<QVector<Resource>> cycles;
+};
+
+// Computes a DependencyReport off the GUI thread, from a snapshot of the project. The resources are scanned in
+// parallel; only the final reachability pass is sequential.
+class DependencyAnalyzer : public QObject {
+  Q_OBJECT
+
+ public:
+  using Report = std::shared_ptr<const DependencyReport>;
+
+  // Relative file paths in the project are resolved against `project_directory`.
+  DependencyAnalyzer(ProjectSnapshots *snapshots, const QString &project_directory, QObject *parent = nullptr);
+
+  // Starts analyzing the current state of the project. A run already in progress is abandoned.
+  void Run();
+  bool IsRunning() const { return watcher_.isRunning(); }
+
+  static Report Analyze(ProjectSnapshots::Snapshot snapshot, quint64 version, const QString &project_directory);
+
+ signals:
+  void Finished(DependencyAnalyzer::Report report);
+
+ private:
+  ProjectSnapshots *snapshots_;
+  QString project_directory_;
+  QFutureWatcher<Report> watcher_;
+};
+
+#endif  // DEPENDENCYANALYZER_H
@@ -0,0 +1,190 @@
+#include "FuzzyResourceIndex.h"
+#include "Components/Logger.h"
+#include "Models/ResourceModelMap.h"
+
+#include <algorithm>
+
+// Each matched character is worth kMatchScore, plus a bonus if it starts a word or continues a run of matches.
+// Characters skipped between two matches cost kGapPenalty each, up to kMaxGapPenalty per gap.
+static constexpr int kMatchScore = 16;
+static constexpr int kWordStartBonus = 24;
+static constexpr int kRunBonus = 16;
+static constexpr int kGapPenalty = 2;
+static constexpr int kMaxGapPenalty = 12;
+// Whole-name bonuses: the query is where the name starts, or is the name.
+static constexpr int kPrefixBonus = 32;
+static constexpr int kExactBonus = 64;
+
+// Lowercases each character on its own, so that positions in the result line up with the original.
+static QString Fold(const QString &text) {
+  QString folded;
+  folded.reserve(text.size());
+  for (const QChar c : text) folded.append(c.toLower());
+  return folded;
+}
+
+static bool IsWordStart(const QString &name, int i) {
+  if (i == 0) return true;
+  const QChar previous = name[i - 1], current = name[i];
+  if (!previous.isLetterOrNumber()) return current.isLetterOrNumber();  // spr_player
+  if (previous.isLower() && current.isUpper()) return true;               // sprPlayer
+  return previous.isLetter() != current.isLetter();                        // room2
+}
+
+FuzzyResourceIndex::FuzzyResourceIndex(QObject *parent) : QObject(parent) {}
+
+void FuzzyResourceIndex::Track(ResourceModelMap *resources) {
+  for (const auto &connection : qAsConst(connections_)) disconnect(connection);
+  connections_.clear();
+  entries_.clear();
+  free_.clear();
+  ids_.clear();
+  for (QVector<int> &posting : postings_) posting.clear();
+  posted_.clear();
+  ++generation_;
+  last_query_.clear();
+  last_matches_.clear();
+
+  resources_ = resources;
+  R_EXPECT_V(resources_) << "Fuzzy index has nothing to track";
+  connections_.append(connect(resources_, &ResourceModelMap::ResourceIndexed, this, &FuzzyResourceIndex::Add));
+  connections_.append(connect(resources_, &ResourceModelMap::ResourceUnindexed, this, &FuzzyResourceIndex::Remove));
+  connections_.append(connect(resources_, &ResourceModelMap::ResourceNameChanged, this, &FuzzyResourceIndex::Add));
+  const QList<MessageModel *> nodes = resources_->IndexedResources();
+  entries_.reserve(nodes.size());
+  for (MessageModel *node : nodes) Add(node);
+}
+
+quint64 FuzzyResourceIndex::CharacterMask(const QString &folded) {
+  quint64 mask = 0;
+  for (const QChar c : folded) {
+    const ushort u = c.unicode();
+    int bit;
+    if (u >= 'a' && u <= 'z') {
+      bit = u - 'a';
+    } else if (u >= '0' && u <= '9') {
+      bit = 26 + (u - '0');
+    } else {
+      bit = 36 + u % 28;  // Everything else shares the remaining bits.
+    }
+    mask |= quint64(1) << bit;
+  }
+  return mask;
+}
+
+int FuzzyResourceIndex::Score(const Entry &entry, const QString &query) {
+  const QString &folded = entry.folded;
+  const int length = folded.size(), count = query.size();
+  // Whether query[next...] can still be matched in order within folded[from...].
+  auto fits = [&](int next, int from) {
+    for (int i = from; next < count && i < length; ++i) {
+      if (folded[i] == query[next]) ++next;
+    }
+    return next == count;
+  };
+  if (!fits(0, 0)) return 0;
+
+  int score = 0, last = -1;
+  for (int next = 0; next < count; ++next) {
+    int at = folded.indexOf(query[next], last + 1);
+    // Rather than break a run or land mid-word, skip ahead to a word starting with this character, if the rest of the
+    // query still fits after it.
+    if (at != last + 1 && !IsWordStart(entry.name, at)) {
+      for (int i = at + 1; i < length; ++i) {
+        if (folded[i] == query[next] && IsWordStart(entry.name, i) && fits(next + 1, i + 1)) {
+          at = i;
+          break;
+        }
+      }
+    }
+    score += kMatchScore;
+    if (IsWordStart(entry.name, at)) score += kWordStartBonus;
+    if (last >= 0 && at == last + 1) score += kRunBonus;
+    if (last >= 0 && at > last + 1) score -= std::min(kMaxGapPenalty, (at - last - 1) * kGapPenalty);
+    last = at;
+  }
+  if (folded.startsWith(query)) score += length == count ? kExactBonus : kPrefixBonus;
+  return std::max(score, 1);
+}
+
+QVector<FuzzyResourceIndex::Match> FuzzyResourceIndex::Search(const QString &query, int limit) const {
+  QVector<Match> matches;
+  const QString folded = Fold(query.simplified().remove(' '));
+  if (folded.isEmpty() || limit <= 0) return matches;
+
+  const quint64 mask = CharacterMask(folded);
+  // Whatever doesn't match a query can't match it with more characters typed, so extending the last query only needs
+  // to look at what that matched. Otherwise only names with the query's rarest character are worth looking at.
+  const QVector<int> *candidates;
+  if (generation_ == last_generation_ && !last_query_.isEmpty() && folded.startsWith(last_query_)) {
+    candidates = &last_matches_;
+  } else {
+    candidates = nullptr;
+    for (int bit = 0; bit < kMaskBits; ++bit) {
+      if (!(mask >> bit & 1)) continue;
+      if (!candidates || postings_[bit].size() < candidates->size()) candidates = &postings_[bit];
+    }
+  }
+
+  QVector<int> matched;
+  for (const int id : *candidates) {
+    const Entry &entry = entries_[id];
+    if (!entry.node || (entry.mask & mask) != mask || entry.folded.size() < folded.size()) continue;
+    if (const int score = Score(entry, folded)) {
+      matches.append({entry.type, entry.name, score});
+      matched.append(id);
+    }
+  }
+  last_query_ = folded;
+  last_matches_ = std::move(matched);
+  last_generation_ = generation_;
+
+  // Among equally good matches, shorter names have less left unmatched.
+  auto better = [](const Match &a, const Match &b) {
+    if (a.score != b.score) return a.score > b.score;
+    if (a.name.size() != b.name.size()) return a.name.size() < b.name.size();
+    const int order = QString::compare(a.name, b.name, Qt::CaseInsensitive);
+    return order != 0 ? order < 0 : a.type < b.type;
+  };
+  if (matches.size() > limit) {
+    std::partial_sort(matches.begin(), matches.begin() + limit, matches.end(), better);
+    matches.resize(limit);
+  } else {
+    std::sort(matches.begin(), matches.end(), better);
+  }
+  return matches;
+}
+
+void FuzzyResourceIndex::Add(MessageModel *node) {
+  Entry entry;
+  if (!resources_->ResourceKeyOf(node, &entry.type, &entry.name)) return;
+  entry.node = node;
+  entry.folded = Fold(entry.name);
+  entry.mask = CharacterMask(entry.folded);
+
+  auto id = ids_.find(node);
+  if (id == ids_.end()) {
+    id = ids_.insert(node, free_.isEmpty() ? entries_.size() : free_.takeLast());
+    if (*id == entries_.size()) {
+      entries_.append(Entry());
+      posted_.append(0);
+    }
+  }
+  // An id stays listed under every bit it was ever listed under, so it is only added to the lists it's missing from.
+  const quint64 unposted = entry.mask & ~posted_[*id];
+  for (int bit = 0; bit < kMaskBits; ++bit) {
+    if (unposted >> bit & 1) postings_[bit].append(*id);
+  }
+  posted_[*id] |= entry.mask;
+  entries_[*id] = std::move(entry);
+  ++generation_;
+}
+
+void FuzzyResourceIndex::Remove(MessageModel *node) {
+  auto id = ids_.find(node);
+  if (id == ids_.end()) return;
+  entries_[*id] = Entry();
+  free_.append(*id);
+  ids_.erase(id);
+  ++generation_;
+}
@@ -0,0 +1,72 @@
+#ifndef FUZZYRESOURCEINDEX_H
+#define FUZZYRESOURCEINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QVector>
+
+class MessageModel;
+class ResourceModelMap;
+
+// Fuzzy lookup of resources by name, for quick-open. A query matches every name containing its characters in order,
+// ignoring case; names where they form runs, or start words ("spr_player" for "sp"), rank first.
+// Names follow the resource map as resources come, go and are renamed. Each name keeps a bitmask of the characters in
+// it, and each character lists the names containing it, so a search only visits the names containing the rarest
+// character of the query. While the query is being typed, each keystroke usually extends the last query, and then only
+// the names which matched that are visited again. A query over a hundred thousand resources is meant to fit
+// comfortably between two keystrokes.
+class FuzzyResourceIndex : public QObject {
+  Q_OBJECT
+
+ public:
+  struct Match {
+    int type;      // TreeNode type case of the resource.
+    QString name;
+    int score;     // Higher is better. Only comparable between matches of the same query.
+  };
+
+  explicit FuzzyResourceIndex(QObject *parent = nullptr);
+
+  // Throws away the current names and indexes those of the given map, which it then follows.
+  void Track(ResourceModelMap *resources);
+
+  // Returns up to `limit` matches for the query, best first. Spaces in the query are ignored.
+  QVector<Match> Search(const QString &query, int limit = 100) const;
+
+ private:
+  struct Entry {
+    MessageModel *node = nullptr;  // Null for free slots.
+    int type = 0;
+    QString name;
+    QString folded;                // Lowercase name, matched against.
+    quint64 mask = 0;              // Characters in `folded`; see CharacterMask.
+  };
+
+  static constexpr int kMaskBits = 64;
+
+  static quint64 CharacterMask(const QString &folded);
+  static int Score(const Entry &entry, const QString &query);
+
+  // Indexes the resource under its current name, replacing any entry it already has.
+  void Add(MessageModel *node);
+  void Remove(MessageModel *node);
+
+  ResourceModelMap *resources_ = nullptr;
+  QList<QMetaObject::Connection> connections_;
+  QVector<Entry> entries_;
+  QVector<int> free_;
+  QHash<MessageModel *, int> ids_;
+  // The ids of the entries with each bit of CharacterMask, which may include entries that have since been removed or
+  // renamed; Search checks the masks again. `posted_` has, by id, the bits each id was listed under.
+  QVector<int> postings_[kMaskBits];
+  QVector<quint64> posted_;
+  quint64 generation_ = 0;  // Bumped whenever an entry changes.
+
+  // The last query searched, and the ids of every entry it matched.
+  mutable QString last_query_;
+  mutable QVector<int> last_matches_;
+  mutable quint64 last_generation_ = 0;
+};
+
+#endif  // FUZZYRESOURCEINDEX_H
@@ -0,0 +1,266 @@
+#include "ProjectSearchIndex.h"
+#include "Components/Logger.h"
+#include "Models/MessageModel.h"
+#include "Models/ResourceModelMap.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Message;
+
+// Edits tend to come in bursts (typing, dragging), so changed resources are re-indexed once things settle down.
+static constexpr int kReindexDelayMs = 250;
+
+ProjectSearchIndex::ProjectSearchIndex(QObject *parent) : QObject(parent) {
+  reindex_timer_.setSingleShot(true);
+  reindex_timer_.setInterval(kReindexDelayMs);
+  connect(&reindex_timer_, &QTimer::timeout, this, &ProjectSearchIndex::ReindexDirty);
+  connect(&build_, &QFutureWatcher<std::shared_ptr<Build>>::finished, this, &ProjectSearchIndex::FinishBuild);
+}
+
+void ProjectSearchIndex::Track(ProjectSnapshots *snapshots, ResourceModelMap *resources) {
+  for (const auto &connection : qAsConst(connections_)) disconnect(connection);
+  connections_.clear();
+  for (const auto &watcher : qAsConst(watchers_)) disconnect(watcher);
+  watchers_.clear();
+  ready_ = false;
+  documents_.clear();
+  free_.clear();
+  ids_.clear();
+  postings_.clear();
+  dirty_.clear();
+  reindex_timer_.stop();
+
+  snapshots_ = snapshots;
+  resources_ = resources;
+  R_EXPECT_V(snapshots_ && resources_) << "Search index has nothing to track";
+  connections_.append(connect(resources_, &ResourceModelMap::ResourceIndexed, this, &ProjectSearchIndex::Add));
+  connections_.append(connect(resources_, &ResourceModelMap::ResourceUnindexed, this, &ProjectSearchIndex::Remove));
+  // Resources are watched from the start, so whatever changes while the index is being built is re-indexed after.
+  for (MessageModel *node : resources_->IndexedResources()) Watch(node);
+  StartBuild();
+  emit Changed();
+}
+
+QStringList ProjectSearchIndex::Words(const QString &text) {
+  QStringList words;
+  int start = -1;
+  for (int i = 0; i <= text.size(); ++i) {
+    const bool word_char = i < text.size() && (text[i].isLetterOrNumber() || text[i] == '_');
+    if (word_char && start < 0) start = i;
+    if (!word_char && start >= 0) {
+      words.append(text.mid(start, i - start).toLower());
+      start = -1;
+    }
+  }
+  return words;
+}
+
+static void CollectStrings(const Message &message, const QString &path, QVector<QPair<QString, QString>> *out) {
+  const google::protobuf::Reflection *refl = message.GetReflection();
+  std::vector<const FieldDescriptor *> fields;
+  refl->ListFields(message, &fields);
+  for (const FieldDescriptor *field : fields) {
+    const QString name = path + QString::fromStdString(field->name());
+    if (field->type() == FieldDescriptor::TYPE_STRING) {
+      if (field->is_repeated()) {
+        for (int i = 0; i < refl->FieldSize(message, field); ++i) {
+          out->append({name + '[' + QString::number(i) + ']',
+                       QString::fromStdString(refl->GetRepeatedString(message, field, i))});
+        }
+      } else {
+        out->append({name, QString::fromStdString(refl->GetString(message, field))});
+      }
+    } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      if (field->is_repeated()) {
+        for (int i = 0; i < refl->FieldSize(message, field); ++i) {
+          CollectStrings(refl->GetRepeatedMessage(message, field, i), name + '[' + QString::number(i) + "].", out);
+        }
+      } else {
+        CollectStrings(refl->GetMessage(message, field), name + '.', out);
+      }
+    }
+  }
+}
+
+ProjectSearchIndex::Document ProjectSearchIndex::DocumentFor(const Message &message) {
+  const auto &tree_node = static_cast<const buffers::TreeNode &>(message);
+  Document document;
+  document.type = tree_node.type_case();
+  document.name = QString::fromStdString(tree_node.name());
+
+  QVector<QPair<QString, QString>> strings;
+  strings.append({"name", document.name});
+  const FieldDescriptor *resource = tree_node.GetReflection()->GetOneofFieldDescriptor(
+      tree_node, buffers::TreeNode::descriptor()->FindOneofByName("type"));
+  if (resource && resource->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE)
+    CollectStrings(tree_node.GetReflection()->GetMessage(tree_node, resource), "", &strings);
+
+  for (const auto &string : qAsConst(strings)) {
+    if (string.second.isEmpty()) continue;
+    for (const QString &word : Words(string.second)) document.words.insert(word);
+    document.fields.append({string.first, string.second});
+  }
+  return document;
+}
+
+std::shared_ptr<ProjectSearchIndex::Build> ProjectSearchIndex::BuildFrom(ProjectSnapshots::Snapshot snapshot) {
+  auto build = std::make_shared<Build>();
+  if (!snapshot) return build;
+
+  build->documents.reserve(snapshot->size());
+  for (const ProjectSnapshots::Resource &resource : *snapshot) build->documents.append(DocumentFor(*resource));
+
+  for (int id = 0; id < build->documents.size(); ++id) {
+    for (const QString &word : qAsConst(build->documents[id].words)) build->postings[word].insert(id);
+  }
+  return build;
+}
+
+void ProjectSearchIndex::StartBuild() {
+  // The snapshot is taken here, on the GUI thread; only the indexing itself happens in the background.
+  build_.setFuture(QtConcurrent::run(&ProjectSearchIndex::BuildFrom, snapshots_->Capture()));
+}
+
+void ProjectSearchIndex::FinishBuild() {
+  if (!snapshots_ || build_.isCanceled()) return;
+  std::shared_ptr<Build> build = build_.result();
+  // The build is kept even if the project changed in the meantime. Resources edited since were marked dirty by their
+  // watchers and are re-indexed below; renamed ones no longer match their documents and are added afresh.
+  documents_ = std::move(build->documents);
+  postings_ = std::move(build->postings);
+  for (int id = 0; id < documents_.size(); ++id) {
+    Document &document = documents_[id];
+    document.node = resources_->GetResourceByName(document.type, document.name);
+    if (!document.node || ids_.contains(document.node)) {
+      // Deleted while the index was being built, or sharing its name with another resource of the same type.
+      Unpost(id);
+      documents_[id] = Document();
+      free_.append(id);
+      continue;
+    }
+    ids_.insert(document.node, id);
+  }
+  ready_ = true;
+  const QList<MessageModel *> watched = watchers_.keys();
+  for (MessageModel *node : watched) {
+    if (!ids_.contains(node)) Add(node);
+  }
+  if (!dirty_.isEmpty()) reindex_timer_.start();
+  emit Changed();
+}
+
+void ProjectSearchIndex::Watch(MessageModel *node) {
+  if (watchers_.contains(node)) return;
+  auto mark_dirty = [this, node]() {
+    dirty_.insert(node);
+    reindex_timer_.start();
+  };
+  // Changes anywhere in the resource bubble up to its node as dataChanged, renames included.
+  watchers_.insert(node, connect(node, &ProtoModel::dataChanged, this, mark_dirty));
+}
+
+void ProjectSearchIndex::Add(MessageModel *node) {
+  if (!ready_) {
+    // Picked up when the build finishes.
+    Watch(node);
+    return;
+  }
+  if (ids_.contains(node)) {
+    dirty_.insert(node);
+    reindex_timer_.start();
+    return;
+  }
+  const int id = free_.isEmpty() ? documents_.size() : free_.takeLast();
+  if (id == documents_.size()) documents_.append(Document());
+  documents_[id] = DocumentFor(*node->GetBuffer());
+  documents_[id].node = node;
+  Post(id);
+  ids_.insert(node, id);
+  Watch(node);
+  emit Changed();
+}
+
+void ProjectSearchIndex::Remove(MessageModel *node) {
+  disconnect(watchers_.take(node));
+  dirty_.remove(node);
+  const int id = ids_.value(node, -1);
+  if (id < 0) return;
+  Unpost(id);
+  documents_[id] = Document();
+  free_.append(id);
+  ids_.remove(node);
+  emit Changed();
+}
+
+void ProjectSearchIndex::Post(int id) {
+  for (const QString &word : qAsConst(documents_[id].words)) postings_[word].insert(id);
+}
+
+void ProjectSearchIndex::Unpost(int id) {
+  for (const QString &word : qAsConst(documents_[id].words)) {
+    auto posting = postings_.find(word);
+    if (posting == postings_.end()) continue;
+    posting->remove(id);
+    if (posting->isEmpty()) postings_.erase(posting);
+  }
+}
+
+void ProjectSearchIndex::ReindexDirty() {
+  if (!ready_ || dirty_.isEmpty()) return;
+  for (MessageModel *node : qAsConst(dirty_)) {
+    const int id = ids_.value(node, -1);
+    if (id < 0) continue;
+    Unpost(id);
+    documents_[id] = DocumentFor(*node->GetBuffer());
+    documents_[id].node = node;
+    Post(id);
+  }
+  dirty_.clear();
+  emit Changed();
+}
+
+QVector<ProjectSearchIndex::Hit> ProjectSearchIndex::Search(const QString &query, int limit) const {
+  QVector<Hit> hits;
+  const QStringList words = Words(query);
+  if (words.isEmpty()) return hits;
+
+  QSet<int> candidates;
+  for (int i = 0; i < words.size(); ++i) {
+    QSet<int> matches;
+    if (i + 1 < words.size()) {
+      matches = postings_.value(words[i]);
+    } else {
+      for (auto it = postings_.lowerBound(words[i]); it != postings_.end() && it.key().startsWith(words[i]); ++it)
+        matches.unite(*it);
+    }
+    if (i == 0) candidates = std::move(matches);
+    else candidates.intersect(matches);
+    if (candidates.isEmpty()) return hits;
+  }
+
+  QVector<int> ordered(candidates.begin(), candidates.end());
+  std::sort(ordered.begin(), ordered.end(), [this](int a, int b) {
+    const Document &left = documents_[a], &right = documents_[b];
+    if (left.type != right.type) return left.type < right.type;
+    return QString::compare(left.name, right.name, Qt::CaseInsensitive) < 0;
+  });
+
+  // The words only narrow things down; the query itself still has to appear verbatim (ignoring case).
+  const QString needle = query.trimmed();
+  for (int id : qAsConst(ordered)) {
+    const Document &document = documents_[id];
+    for (const Field &field : document.fields) {
+      if (!field.text.contains(needle, Qt::CaseInsensitive)) continue;
+      const QVector<QStringRef> lines = field.text.splitRef('\n');
+      for (int line = 0; line < lines.size(); ++line) {
+        if (!lines[line].contains(needle, Qt::CaseInsensitive)) continue;
+        hits.append({document.type, document.name, field.path, line, lines[line].trimmed().toString()});
+        if (hits.size() >= limit) return hits;
+      }
+    }
+  }
+  return hits;
+}
@@ -0,0 +1,99 @@
+#ifndef PROJECTSEARCHINDEX_H
+#define PROJECTSEARCHINDEX_H
+
+#include "Components/ProjectSnapshots.h"
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+
+#include <memory>
+
+class MessageModel;
+class ResourceModelMap;
+
+// Inverted index over every string field in the project: resource names, script and shader code, object event code,
+// timeline moment code, and so on. Each identifier-like word maps to the resources containing it. A query looks up its
+// words, then scans only the resources having all of them for the exact text.
+// The index is first built off the GUI thread from a project snapshot. Each resource is re-indexed on its own shortly
+// after it changes, including changes made while that first build was running.
+class ProjectSearchIndex : public QObject {
+  Q_OBJECT
+
+ public:
+  struct Hit {
+    int type;              // TreeNode type case of the resource.
+    QString resourceName;
+    QString field;         // Path of the string field within the resource, e.g. "egm_events[2].code".
+    int line;              // Zero-based line within the field.
+    QString text;          // The matching line.
+  };
+
+  explicit ProjectSearchIndex(QObject *parent = nullptr);
+
+  // Throws away the current index and builds a new one for the project the snapshots are tracking.
+  void Track(ProjectSnapshots *snapshots, ResourceModelMap *resources);
+
+  bool IsReady() const { return ready_; }
+
+  // Case-insensitive search for the given text. Every word in the query but the last has to match a whole word in the
+  // resource; the last may be the beginning of one, so results show up while the user is still typing.
+  QVector<Hit> Search(const QString &query, int limit = 1000) const;
+
+  // Lowercased identifier-like words of the given text, as the index stores them.
+  static QStringList Words(const QString &text);
+
+ signals:
+  // Emitted whenever search results may have changed: after a (re)build, and after changed resources are re-indexed.
+  void Changed();
+
+ private:
+  struct Field {
+    QString path;
+    QString text;
+  };
+  struct Document {
+    MessageModel *node = nullptr;  // Live model of the resource's TreeNode; null for free slots.
+    int type = 0;
+    QString name;
+    QVector<Field> fields;
+    QSet<QString> words;
+  };
+  struct Build {
+    QVector<Document> documents;
+    QMap<QString, QSet<int>> postings;
+  };
+
+  static std::shared_ptr<Build> BuildFrom(ProjectSnapshots::Snapshot snapshot);
+  static Document DocumentFor(const google::protobuf::Message &tree_node);
+
+  void StartBuild();
+  void FinishBuild();
+  void Watch(MessageModel *node);
+  void Add(MessageModel *node);
+  void Remove(MessageModel *node);
+  void Post(int id);
+  void Unpost(int id);
+  void ReindexDirty();
+
+  ProjectSnapshots *snapshots_ = nullptr;
+  ResourceModelMap *resources_ = nullptr;
+  QList<QMetaObject::Connection> connections_;
+  QFutureWatcher<std::shared_ptr<Build>> build_;
+  bool ready_ = false;
+
+  QVector<Document> documents_;
+  QVector<int> free_;
+  QHash<MessageModel *, int> ids_;
+  QHash<MessageModel *, QMetaObject::Connection> watchers_;
+  QMap<QString, QSet<int>> postings_;  // Ordered, so the last word of a query can match as a prefix.
+
+  QSet<MessageModel *> dirty_;
+  QTimer reindex_timer_;
+};
+
+#endif  // PROJECTSEARCHINDEX_H
@@ -0,0 +1,104 @@
+#include "ProjectSnapshots.h"
+#include "Components/Logger.h"
+#include "Models/MessageModel.h"
+#include "Models/ResourceModelMap.h"
+
+#include <QMutexLocker>
+
+#include <functional>
+
+ProjectSnapshots::ProjectSnapshots(QObject *parent) : QObject(parent) {}
+
+void ProjectSnapshots::Track(const buffers::Project *project, ProtoModel *root_model, ResourceModelMap *resources) {
+  for (const auto &connection : qAsConst(connections_)) disconnect(connection);
+  connections_.clear();
+  for (const WatchedResource &watched : qAsConst(watched_)) {
+    for (const auto &connection : watched.connections) disconnect(connection);
+  }
+  watched_.clear();
+  watched_buffers_.clear();
+  copies_.clear();
+
+  project_ = project;
+  Invalidate();
+  {
+    QMutexLocker lock(&latest_mutex_);
+    latest_.reset();
+    latest_version_ = 0;
+  }
+
+  R_EXPECT_V(root_model && resources) << "Tracking a project without models; snapshots will never be refreshed";
+  // Every edit reaches the root as a dataChanged through ParentDataChanged, whatever the depth it happened at.
+  auto invalidate = [this]() { Invalidate(); };
+  connections_.append(connect(root_model, &ProtoModel::dataChanged, this, invalidate));
+  connections_.append(connect(root_model, &ProtoModel::modelReset, this, invalidate));
+  connections_.append(connect(root_model, &ProtoModel::rowsInserted, this, invalidate));
+  connections_.append(connect(root_model, &ProtoModel::rowsRemoved, this, invalidate));
+  connections_.append(connect(root_model, &ProtoModel::rowsMoved, this, invalidate));
+
+  connections_.append(connect(resources, &ResourceModelMap::ResourceIndexed, this, &ProjectSnapshots::Watch));
+  connections_.append(connect(resources, &ResourceModelMap::ResourceUnindexed, this, &ProjectSnapshots::Unwatch));
+  for (MessageModel *node : resources->IndexedResources()) Watch(node);
+}
+
+void ProjectSnapshots::Watch(MessageModel *node) {
+  Unwatch(node);
+  WatchedResource &watched = watched_[node];
+  watched.buffer = node->GetBuffer();
+  watched_buffers_.insert(watched.buffer);
+  // A new resource may sit where a deleted one used to, so nothing copied from that address can be trusted.
+  copies_.remove(watched.buffer);
+  // Changes anywhere in the resource bubble up to its node as dataChanged, renames included.
+  auto changed = [this, buffer = watched.buffer]() { copies_.remove(buffer); };
+  watched.connections.append(connect(node, &ProtoModel::dataChanged, this, changed));
+  watched.connections.append(connect(node, &ProtoModel::modelReset, this, changed));
+}
+
+void ProjectSnapshots::Unwatch(MessageModel *node) {
+  auto watched = watched_.find(node);
+  if (watched == watched_.end()) return;
+  for (const auto &connection : qAsConst(watched->connections)) disconnect(connection);
+  copies_.remove(watched->buffer);
+  watched_buffers_.remove(watched->buffer);
+  watched_.erase(watched);
+}
+
+ProjectSnapshots::Snapshot ProjectSnapshots::Capture() {
+  if (!project_) return nullptr;
+  {
+    QMutexLocker lock(&latest_mutex_);
+    if (latest_ && latest_version_ == version_) return latest_;
+  }
+
+  // Only resources without a copy from the last capture are copied; dropping the copies nobody visits here also
+  // forgets resources which have since been deleted.
+  auto resources = std::make_shared<QVector<Resource>>();
+  QHash<const google::protobuf::Message *, Resource> copies;
+  std::function<void(const buffers::TreeNode &)> visit = [&](const buffers::TreeNode &node) {
+    if (!node.has_folder()) {
+      Resource copy = copies_.value(&node);
+      if (!copy) copy = std::make_shared<const buffers::TreeNode>(node);
+      if (watched_buffers_.contains(&node)) copies.insert(&node, copy);
+      resources->append(std::move(copy));
+      return;
+    }
+    for (const buffers::TreeNode &child : node.folder().children()) visit(child);
+  };
+  visit(project_->game().root());
+  copies_ = std::move(copies);
+
+  Snapshot snapshot = std::move(resources);
+  {
+    QMutexLocker lock(&latest_mutex_);
+    latest_ = snapshot;
+    latest_version_ = version_;
+  }
+  emit SnapshotCaptured(version_);
+  return snapshot;
+}
+
+ProjectSnapshots::Snapshot ProjectSnapshots::Latest(quint64 *version) const {
+  QMutexLocker lock(&latest_mutex_);
+  if (version) *version = latest_version_;
+  return latest_;
+}
@@ -0,0 +1,79 @@
+#ifndef PROJECTSNAPSHOTS_H
+#define PROJECTSNAPSHOTS_H
+
+#include "project.pb.h"
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QVector>
+
+#include <memory>
+
+class MessageModel;
+class ProtoModel;
+class ResourceModelMap;
+
+// Hands out immutable copies of the open project's resources so that they can be read off the GUI thread.
+// The live project may only be touched from the GUI thread, and protobuf messages can't share structure, so each
+// resource in a snapshot is a deep copy. Copies are taken lazily and one resource at a time: every change to the
+// project bumps its version, and the first request for a snapshot after that copies only the resources which changed
+// since the last one. Every other resource is shared with the previous snapshot. Walking the tree to find the
+// resources is cheap next to copying them, but it still happens on the GUI thread, once per version.
+class ProjectSnapshots : public QObject {
+  Q_OBJECT
+
+ public:
+  using Resource = std::shared_ptr<const buffers::TreeNode>;
+  // The tree nodes of every resource in the project, in tree order. Folders are left out.
+  using Snapshot = std::shared_ptr<const QVector<Resource>>;
+
+  explicit ProjectSnapshots(QObject *parent = nullptr);
+
+  // Starts tracking the given project, replacing whatever was tracked before.
+  // Changes are observed through the signals of the model at the root of its resource tree, and changes to single
+  // resources through the models the resource map has indexed.
+  void Track(const buffers::Project *project, ProtoModel *root_model, ResourceModelMap *resources);
+
+  // The version of the live project, bumped on every change. GUI thread only.
+  quint64 Version() const { return version_; }
+
+  // Returns a snapshot of the current state of the project, copying the resources that changed since the last capture.
+  // Must be called from the GUI thread; the returned snapshot can be read from any thread.
+  Snapshot Capture();
+
+  // Returns the most recently captured snapshot and its version. The snapshot may be stale, or null if none has been
+  // captured for the current project. Safe to call from any thread.
+  Snapshot Latest(quint64 *version = nullptr) const;
+
+ signals:
+  void SnapshotCaptured(quint64 version);
+
+ private:
+  struct WatchedResource {
+    const google::protobuf::Message *buffer;
+    QList<QMetaObject::Connection> connections;
+  };
+
+  void Invalidate() { ++version_; }
+  void Watch(MessageModel *node);
+  void Unwatch(MessageModel *node);
+
+  const buffers::Project *project_ = nullptr;
+  QList<QMetaObject::Connection> connections_;
+  quint64 version_ = 0;
+
+  // The copy of each resource taken by the last capture, by its live tree node. Dropped as soon as it changes. Only
+  // resources which are watched are kept; anything else (e.g. one whose name clashes) is copied every time.
+  QHash<const google::protobuf::Message *, Resource> copies_;
+  QHash<MessageModel *, WatchedResource> watched_;
+  QSet<const google::protobuf::Message *> watched_buffers_;
+
+  mutable QMutex latest_mutex_;
+  Snapshot latest_;
+  quint64 latest_version_ = 0;
+};
+
+#endif  // PROJECTSNAPSHOTS_H
@@ -231,6 +231,11 @@ void QMenuView::createMenu(const QModelIndex &parent, QMenu *parentMenu, QMenu *
     return;
   }
 
+  if (d->m_model->canFetchMore(parent))
+  {
+    d->m_model->fetchMore(parent);
+  }
+
   int end = d->m_model->rowCount(parent);
   for (int i = 0; i < end; ++i)
   {
@@ -0,0 +1,135 @@
+#include "ThumbnailService.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+
+#include <functional>
+#include <limits>
+
+namespace {
+
+// QtConcurrent::run can't say how urgent its work is, so thumbnails are queued on the pool directly.
+class ThumbnailTask : public QRunnable {
+ public:
+  explicit ThumbnailTask(std::function<void()> work): work_(std::move(work)) {}
+  void run() override { work_(); }
+
+ private:
+  std::function<void()> work_;
+};
+
+}  // namespace
+
+ThumbnailService *ThumbnailService::Instance() {
+  static ThumbnailService *const service = new ThumbnailService();
+  return service;
+}
+
+// The cache directory is checked against its budget on startup and after this many thumbnails have been made.
+static constexpr int kThumbnailsPerPrune = 256;
+
+ThumbnailService::ThumbnailService(QObject *parent): QObject(parent) {
+  // Leave a core to the GUI thread, and the global pool to everyone else.
+  pool_.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+  const QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+  if (!dir.isEmpty() && QDir().mkpath(dir + "/thumbnails")) cache_dir_ = dir + "/thumbnails";
+  else qDebug() << "No writable cache location; thumbnails will be made again every session";
+  SchedulePrune();
+}
+
+QString ThumbnailService::CacheKey(const QString &path, const QSize &size, const QDateTime &modified) {
+  return path + '|' + QString::number(size.width()) + 'x' + QString::number(size.height()) + '|' +
+         QString::number(modified.toMSecsSinceEpoch());
+}
+
+void ThumbnailService::Request(const QString &path, const QSize &size) {
+  const QDateTime modified = QFileInfo(path).lastModified();
+  const QString key = CacheKey(path, size, modified);
+  if (queued_.contains(key)) return;
+
+  queued_.insert(key);
+  if (queued_.size() == 1) next_priority_ = 0;
+  // Every version of an image shares the hash of its path and size, so the stale ones can be found and deleted.
+  QString cache_file;
+  if (!cache_dir_.isEmpty()) {
+    const QString image = CacheKey(path, size, {});
+    cache_file = cache_dir_ + '/' + QCryptographicHash::hash(image.toUtf8(), QCryptographicHash::Sha1).toHex() + '-' +
+                 QString::number(modified.toMSecsSinceEpoch()) + ".png";
+  }
+  // The latest requests are for whatever is on screen right now, so they jump the queue; rows which were scrolled past
+  // a moment ago can wait.
+  pool_.start(new ThumbnailTask([this, key, path, size, cache_file]() {
+    const QImage image = MakeThumbnail(path, size, cache_file);
+    QMetaObject::invokeMethod(this, [this, key, path, size, image]() { Finished(key, path, size, image); },
+                              Qt::QueuedConnection);
+  }), ++next_priority_);
+}
+
+QImage ThumbnailService::MakeThumbnail(const QString &path, const QSize &size, const QString &cache_file) {
+  if (!cache_file.isEmpty()) {
+    QImage cached(cache_file);
+    if (!cached.isNull()) {
+      // Pruning goes by modification time, so a thumbnail that is read counts as recently used.
+      QFile file(cache_file);
+      if (file.open(QIODevice::ReadWrite)) {
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+      }
+      return cached;
+    }
+  }
+
+  QImageReader reader(path);
+  const QSize full = reader.size();
+  const bool scaled = full.isValid() && (full.width() > size.width() || full.height() > size.height());
+  // Formats that can scale while decoding (JPEG) skip most of the work this way; QImageReader scales the rest after.
+  if (scaled) reader.setScaledSize(full.scaled(size, Qt::KeepAspectRatio));
+  const QImage image = reader.read();
+  if (image.isNull()) {
+    qDebug() << "Failed to read image" << path << ":" << reader.errorString();
+    return image;
+  }
+
+  // Images which already fit are as quick to decode again as their copy would be to read.
+  if (scaled && !cache_file.isEmpty()) {
+    const QFileInfo info(cache_file);
+    const QString versions = info.fileName().left(info.fileName().lastIndexOf('-')) + "-*.png";
+    for (const QFileInfo &stale : info.dir().entryInfoList({versions}, QDir::Files)) QFile::remove(stale.filePath());
+    QSaveFile out(cache_file);
+    if (out.open(QIODevice::WriteOnly) && image.save(&out, "PNG")) out.commit();
+  }
+  return image;
+}
+
+void ThumbnailService::PruneDiskCache(const QString &dir) {
+  QFileInfoList files = QDir(dir).entryInfoList({"*.png"}, QDir::Files, QDir::Time | QDir::Reversed);
+  qint64 bytes = 0;
+  for (const QFileInfo &file : qAsConst(files)) bytes += file.size();
+  // Prune down to three quarters of the budget, so that it isn't exceeded again by the very next few thumbnails.
+  const qint64 target = kDiskCacheBudget / 4 * 3;
+  if (bytes <= kDiskCacheBudget) return;
+  for (const QFileInfo &file : qAsConst(files)) {
+    if (bytes <= target) break;
+    if (QFile::remove(file.filePath())) bytes -= file.size();
+  }
+}
+
+void ThumbnailService::SchedulePrune() {
+  made_since_prune_ = 0;
+  if (cache_dir_.isEmpty()) return;
+  // Lowest priority: it can wait for every thumbnail someone is looking at.
+  pool_.start(new ThumbnailTask([dir = cache_dir_]() { PruneDiskCache(dir); }), std::numeric_limits<int>::min());
+}
+
+void ThumbnailService::Finished(const QString &key, const QString &path, const QSize &size, const QImage &image) {
+  queued_.remove(key);
+  if (++made_since_prune_ >= kThumbnailsPerPrune) SchedulePrune();
+  emit ThumbnailReady(path, size, QPixmap::fromImage(image));
+}
@@ -0,0 +1,57 @@
+#ifndef THUMBNAILSERVICE_H
+#define THUMBNAILSERVICE_H
+
+#include <QDateTime>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QSet>
+#include <QSize>
+#include <QThreadPool>
+
+// Scaled-down previews of image files, made on a pool of worker threads so that views listing many images (sprite
+// subimages, the resource tree) never decode one while painting.
+// Thumbnails are keyed by file path, the size they were scaled to fit and the file's modification time, so an image
+// changed on disk is decoded again instead of being served stale. The service keeps nothing in memory: whoever asked
+// for a thumbnail caches it under their own budget (ArtManager, for icons). Thumbnails of images that actually had to
+// be scaled down are written to a cache directory, so the next session doesn't have to decode every large image again.
+// Each image keeps only its latest version there, and the directory as a whole is held to a budget, dropping the least
+// recently read thumbnails first.
+class ThumbnailService : public QObject {
+  Q_OBJECT
+
+ public:
+  static constexpr qint64 kDiskCacheBudget = qint64(256) << 20;
+
+  static ThumbnailService *Instance();
+
+  // Queues a thumbnail of the image at `path`, scaled down to fit `size`, to be made; ThumbnailReady announces it.
+  // A thumbnail already queued isn't queued again. Must be called on the GUI thread.
+  void Request(const QString &path, const QSize &size);
+
+ signals:
+  // A thumbnail queued by Request is done. `thumbnail` is null if the image couldn't be read.
+  void ThumbnailReady(const QString &path, const QSize &size, const QPixmap &thumbnail);
+
+ private:
+  explicit ThumbnailService(QObject *parent = nullptr);
+
+  static QString CacheKey(const QString &path, const QSize &size, const QDateTime &modified);
+  // Reads the thumbnail from `cache_file` if it's there, or else decodes and scales the image and saves it there,
+  // deleting the thumbnails of older versions of the image. Runs on a worker thread.
+  static QImage MakeThumbnail(const QString &path, const QSize &size, const QString &cache_file);
+  // Deletes the least recently read thumbnails in `dir` until it fits well within kDiskCacheBudget. Runs on a worker
+  // thread.
+  static void PruneDiskCache(const QString &dir);
+
+  void Finished(const QString &key, const QString &path, const QSize &size, const QImage &image);
+  void SchedulePrune();
+
+  QThreadPool pool_;
+  QSet<QString> queued_;
+  QString cache_dir_;     // Empty if there's nowhere to write thumbnails to.
+  int next_priority_ = 0;
+  int made_since_prune_ = 0;
+};
+
+#endif  // THUMBNAILSERVICE_H
@@ -0,0 +1,92 @@
+#include "DependencyReportDialog.h"
+#include "project.pb.h"
+
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLocale>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+enum ItemRoles { TypeRole = Qt::UserRole, NameRole };
+
+static QString TypeName(int type) {
+  const auto* field = buffers::TreeNode::descriptor()->FindFieldByNumber(type);
+  return field ? QString::fromStdString(field->name()) : QString();
+}
+
+static QTreeWidgetItem* ResourceItem(QTreeWidgetItem* parent, const DependencyReport::Resource& resource,
+                                     const QString& detail) {
+  auto* item = new QTreeWidgetItem(parent, {resource.name, TypeName(resource.type), detail});
+  item->setData(0, TypeRole, resource.type);
+  item->setData(0, NameRole, resource.name);
+  return item;
+}
+
+DependencyReportDialog::DependencyReportDialog(ProjectSnapshots* snapshots, const QString& projectDirectory,
+                                               QWidget* parent)
+    : QDialog(parent), _analyzer(new DependencyAnalyzer(snapshots, projectDirectory, this)) {
+  setWindowTitle(tr("Resource Dependencies"));
+  setAttribute(Qt::WA_DeleteOnClose);
+  resize(640, 480);
+
+  QVBoxLayout* layout = new QVBoxLayout(this);
+  _summary = new QLabel(this);
+  layout->addWidget(_summary);
+
+  _tree = new QTreeWidget(this);
+  _tree->setHeaderLabels({tr("Resource"), tr("Type"), tr("Details")});
+  _tree->header()->setStretchLastSection(true);
+  layout->addWidget(_tree);
+
+  QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+  _refresh = buttons->addButton(tr("Refresh"), QDialogButtonBox::ActionRole);
+  layout->addWidget(buttons);
+
+  connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+  connect(_refresh, &QPushButton::clicked, this, &DependencyReportDialog::Refresh);
+  connect(_analyzer, &DependencyAnalyzer::Finished, this, &DependencyReportDialog::Show);
+  connect(_tree, &QTreeWidget::itemActivated, this, &DependencyReportDialog::ItemActivated);
+
+  Refresh();
+}
+
+void DependencyReportDialog::Refresh() {
+  _refresh->setEnabled(false);
+  _summary->setText(tr("Analyzing project..."));
+  _analyzer->Run();
+}
+
+void DependencyReportDialog::Show(DependencyAnalyzer::Report report) {
+  _refresh->setEnabled(true);
+  _tree->clear();
+  const QLocale locale;
+  _summary->setText(tr("%1 of %2 resources are used. The unused ones take up %3 on disk.")
+                        .arg(report->usedCount)
+                        .arg(report->resourceCount)
+                        .arg(locale.formattedDataSize(report->orphanBytes)));
+
+  auto* orphans = new QTreeWidgetItem(_tree, {tr("Unused resources (%1)").arg(report->orphans.size())});
+  for (const auto& orphan : report->orphans) ResourceItem(orphans, orphan, locale.formattedDataSize(orphan.diskBytes));
+
+  auto* broken = new QTreeWidgetItem(_tree, {tr("Broken references (%1)").arg(report->brokenReferences.size())});
+  for (const auto& reference : report->brokenReferences) {
+    ResourceItem(broken, reference.from,
+                 tr("%1 refers to missing %2 \"%3\"").arg(reference.field, reference.targetType, reference.targetName));
+  }
+
+  auto* cycles = new QTreeWidgetItem(_tree, {tr("Reference cycles (%1)").arg(report->cycles.size())});
+  for (const auto& cycle : report->cycles) {
+    auto* group = new QTreeWidgetItem(cycles, {tr("%n resource(s)", "", cycle.size())});
+    for (const auto& resource : cycle) ResourceItem(group, resource, QString());
+  }
+
+  _tree->expandToDepth(0);
+  _tree->resizeColumnToContents(0);
+}
+
+void DependencyReportDialog::ItemActivated(QTreeWidgetItem* item) {
+  const QVariant type = item->data(0, TypeRole);
+  if (type.isValid()) emit ResourceActivated(type.toInt(), item->data(0, NameRole).toString());
+}
@@ -0,0 +1,35 @@
+#ifndef DEPENDENCYREPORTDIALOG_H
+#define DEPENDENCYREPORTDIALOG_H
+
+#include "Components/DependencyAnalyzer.h"
+
+#include <QDialog>
+
+class QLabel;
+class QPushButton;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+// Shows which resources the project never uses, what they cost on disk, references to resources that don't exist,
+// and reference cycles. The analysis runs in the background; the dialog stays responsive while it does.
+class DependencyReportDialog : public QDialog {
+  Q_OBJECT
+
+ public:
+  DependencyReportDialog(ProjectSnapshots* snapshots, const QString& projectDirectory, QWidget* parent);
+
+ signals:
+  void ResourceActivated(int type, const QString& name);
+
+ private:
+  void Refresh();
+  void Show(DependencyAnalyzer::Report report);
+  void ItemActivated(QTreeWidgetItem* item);
+
+  DependencyAnalyzer* _analyzer;
+  QLabel* _summary;
+  QTreeWidget* _tree;
+  QPushButton* _refresh;
+};
+
+#endif  // DEPENDENCYREPORTDIALOG_H
@@ -3,6 +3,7 @@
 
 #include "PreferencesKeys.h"
 #include "KeyBindingPreferences.h"
+#include "Components/ArtManager.h"
 #include "Components/Logger.h"
 
 #include <QFileDialog>
@@ -180,6 +181,8 @@ void PreferencesDialog::apply() {
   const QString &styleName = ui->styleCombo->currentText();
   settings.setValue(styleNameKey(), styleName);
   QApplication::setStyle(styleName);
+  settings.setValue(imageCacheBudgetKey(), ui->imageCacheSpinBox->value());
+  ArtManager::SetImageCacheBudget(qint64(ui->imageCacheSpinBox->value()) << 20);
   settings.endGroup();  // Preferences/Appearance
 
   settings.endGroup();  // Preferences
@@ -202,6 +205,7 @@ void PreferencesDialog::reset() {
     if (style()->objectName().toLower() == styleName.toLower())
       ui->styleCombo->setCurrentText(styleName);
   }
+  ui->imageCacheSpinBox->setValue(imageCacheBudgetMiB());
 
   this->setupKeybindingContextUI();
 }
@@ -213,6 +217,7 @@ void PreferencesDialog::restoreDefaultsClicked() {
   settings.remove(preferencesKey());
 
   QApplication::setStyle(defaultStyle);
+  ArtManager::SetImageCacheBudget(qint64(imageCacheBudgetMiB()) << 20);
 
   this->reset();
 }
@@ -23,6 +23,7 @@ inline QString submitIssueURLKey() { return QStringLiteral("submitIssueURL"); }
 
 inline QString appearanceKey() { return QStringLiteral("Appearance"); }
 inline QString styleNameKey() { return QStringLiteral("styleName"); }
+inline QString imageCacheBudgetKey() { return QStringLiteral("imageCacheBudgetMiB"); }
 
 inline QString keybindingKey() { return QStringLiteral("Keybinding"); }
 
@@ -54,4 +55,10 @@ inline QString submitIssueURL() {
   return settings.value(path, "https://github.com/enigma-dev/RadialGM/issues").toString();
 }
 
+inline int imageCacheBudgetMiB() {
+  QSettings settings;
+  QString path = preferencesKey() + "/" + appearanceKey() + "/" + imageCacheBudgetKey();
+  return settings.value(path, 256).toInt();
+}
+
 #endif  // PREFERENCESKEYS_H
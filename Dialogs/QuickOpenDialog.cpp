@@ -0,0 +1,86 @@
+#include "QuickOpenDialog.h"
+#include "Components/FuzzyResourceIndex.h"
+#include "treenode.pb.h"
+
+#include <QApplication>
+#include <QKeyEvent>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QVBoxLayout>
+
+enum ItemRoles { TypeRole = Qt::UserRole, NameRole };
+
+static QString TypeName(int type) {
+  const auto* field = buffers::TreeNode::descriptor()->FindFieldByNumber(type);
+  return field ? QString::fromStdString(field->name()) : QString();
+}
+
+QuickOpenDialog::QuickOpenDialog(const FuzzyResourceIndex* index, QWidget* parent)
+    : QDialog(parent, Qt::Popup), _index(index) {
+  setAttribute(Qt::WA_DeleteOnClose);
+  resize(480, 360);
+
+  QVBoxLayout* layout = new QVBoxLayout(this);
+  _query = new QLineEdit(this);
+  _query->setPlaceholderText(tr("Open resource by name"));
+  _query->installEventFilter(this);
+  layout->addWidget(_query);
+
+  _results = new QListWidget(this);
+  _results->setUniformItemSizes(true);
+  _results->setFocusPolicy(Qt::NoFocus);
+  layout->addWidget(_results);
+
+  _status = new QLabel(this);
+  layout->addWidget(_status);
+
+  connect(_query, &QLineEdit::textChanged, this, &QuickOpenDialog::Search);
+  connect(_query, &QLineEdit::returnPressed, this, [this]() { ItemActivated(_results->currentItem()); });
+  connect(_results, &QListWidget::itemActivated, this, &QuickOpenDialog::ItemActivated);
+  connect(_results, &QListWidget::itemClicked, this, &QuickOpenDialog::ItemActivated);
+
+  // Drop down from the top of the parent window, like a menu.
+  if (parent) {
+    const QWidget* window = parent->window();
+    move(window->mapToGlobal(QPoint((window->width() - width()) / 2, window->height() / 8)));
+  }
+  _query->setFocus();
+}
+
+bool QuickOpenDialog::eventFilter(QObject* watched, QEvent* event) {
+  // The cursor stays in the search box; the arrow keys walk the results.
+  if (watched == _query && event->type() == QEvent::KeyPress) {
+    const int key = static_cast<QKeyEvent*>(event)->key();
+    if (key == Qt::Key_Up || key == Qt::Key_Down || key == Qt::Key_PageUp || key == Qt::Key_PageDown) {
+      QApplication::sendEvent(_results, event);
+      return true;
+    }
+  }
+  return QDialog::eventFilter(watched, event);
+}
+
+void QuickOpenDialog::Search() {
+  _results->clear();
+  const QString query = _query->text();
+  if (query.trimmed().isEmpty()) {
+    _status->clear();
+    return;
+  }
+
+  const auto matches = _index->Search(query);
+
+  for (const auto& match : matches) {
+    auto* item = new QListWidgetItem(tr("%1  (%2)").arg(match.name, TypeName(match.type)), _results);
+    item->setData(TypeRole, match.type);
+    item->setData(NameRole, match.name);
+  }
+  _results->setCurrentRow(0);
+  _status->setText(matches.isEmpty() ? tr("No matches") : QString());
+}
+
+void QuickOpenDialog::ItemActivated(QListWidgetItem* item) {
+  if (!item) return;
+  emit ResourceActivated(item->data(TypeRole).toInt(), item->data(NameRole).toString());
+  close();
+}
@@ -0,0 +1,36 @@
+#ifndef QUICKOPENDIALOG_H
+#define QUICKOPENDIALOG_H
+
+#include <QDialog>
+
+class FuzzyResourceIndex;
+class QLabel;
+class QLineEdit;
+class QListWidget;
+class QListWidgetItem;
+
+// Popup for jumping to a resource by typing part of its name. Results are ranked on every keystroke; Enter (or a
+// click) asks for the selected resource to be opened, and closes the popup.
+class QuickOpenDialog : public QDialog {
+  Q_OBJECT
+
+ public:
+  QuickOpenDialog(const FuzzyResourceIndex* index, QWidget* parent);
+
+ signals:
+  void ResourceActivated(int type, const QString& name);
+
+ protected:
+  bool eventFilter(QObject* watched, QEvent* event) override;
+
+ private:
+  void Search();
+  void ItemActivated(QListWidgetItem* item);
+
+  const FuzzyResourceIndex* _index;
+  QLineEdit* _query;
+  QListWidget* _results;
+  QLabel* _status;
+};
+
+#endif  // QUICKOPENDIALOG_H
@@ -1,8 +1,10 @@
 #include "MainWindow.h"
 #include "ui_MainWindow.h"
 
+#include "Dialogs/DependencyReportDialog.h"
 #include "Dialogs/PreferencesDialog.h"
 #include "Dialogs/PreferencesKeys.h"
+#include "Dialogs/QuickOpenDialog.h"
 
 #include "Editors/BackgroundEditor.h"
 #include "Editors/FontEditor.h"
@@ -17,7 +19,9 @@
 #include "Editors/TimelineEditor.h"
 
 #include "Components/ArtManager.h"
+#include "Components/FuzzyResourceIndex.h"
 #include "Components/Logger.h"
+#include "Widgets/ProjectSearchDock.h"
 
 #include "Plugins/RGMPlugin.h"
 #include "Plugins/ServerPlugin.h"
@@ -42,6 +46,7 @@ MainWindow *MainWindow::_instance = nullptr;
 ResourceModelMap *MainWindow::resourceMap = nullptr;
 TreeModel *MainWindow::treeModel = nullptr;
 MessageModel *MainWindow::protoModel = nullptr;
+ProjectSnapshots *MainWindow::projectSnapshots = nullptr;
 std::unique_ptr<EventData> MainWindow::_event_data;
 
 static QTextEdit *diagnosticTextEdit = nullptr;
@@ -115,7 +120,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), _ui(new Ui::MainW
 
   egm::LibEGMInit(_event_data.get());
 
-  ArtManager::Init();
+  ArtManager::Init(qint64(imageCacheBudgetMiB()) << 20);
 
   _instance = this;
 
@@ -157,6 +162,29 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), _ui(new Ui::MainW
     }
   });
 
+  _projectSearch = new ProjectSearchIndex(this);
+  _searchDock = new ProjectSearchDock(_projectSearch, this);
+  addDockWidget(Qt::BottomDockWidgetArea, _searchDock);
+  tabifyDockWidget(_ui->outputDockWidget, _searchDock);
+  _ui->outputDockWidget->raise();
+  connect(_searchDock, &ProjectSearchDock::ResourceActivated, this, &MainWindow::openResource);
+  QAction *findInProject = _ui->menuEdit->addAction(tr("Find in Project..."), _searchDock, &ProjectSearchDock::Activate);
+  // Ctrl+Shift+F is Create Font.
+  findInProject->setShortcut(QKeySequence(tr("Ctrl+Alt+F")));
+  _resourceNames = new FuzzyResourceIndex(this);
+  QAction *quickOpen = _ui->menuEdit->addAction(tr("Open Resource..."), this, [this]() {
+    auto *dialog = new QuickOpenDialog(_resourceNames, this);
+    connect(dialog, &QuickOpenDialog::ResourceActivated, this, &MainWindow::openResource);
+    dialog->show();
+  });
+  // Ctrl+P is Print in the information editor, and Ctrl+Shift+O is Create Object.
+  quickOpen->setShortcut(QKeySequence(tr("Ctrl+T")));
+  _ui->menuResources->addAction(tr("Analyze Dependencies..."), this, [this]() {
+    auto *dialog = new DependencyReportDialog(projectSnapshots, _projectDirectory, this);
+    connect(dialog, &DependencyReportDialog::ResourceActivated, this, &MainWindow::openResource);
+    dialog->show();
+  });
+
   this->readSettings();
   this->_recentFiles = new RecentFiles(this, this->_ui->menuRecent, this->_ui->actionClearRecentMenu);
 
@@ -185,9 +213,20 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), _ui(new Ui::MainW
 }
 
 MainWindow::~MainWindow() {
-  if (protoModel) delete protoModel;
+  // Everything below points into the project's arena, which goes away with our members. Editors have already been
+  // asked to close by closeEvent; QWidget would only delete them after that.
+  qDeleteAll(_ui->mdiArea->subWindowList());
+  // The tree reads from the models, so it goes first.
   if (treeModel) delete treeModel;
+  treeModel = nullptr;
+  delete _searchDock;
+  delete _projectSearch;
+  delete projectSnapshots;
+  projectSnapshots = nullptr;
+  if (protoModel) delete protoModel;
+  protoModel = nullptr;
   if (resourceMap) delete resourceMap;
+  resourceMap = nullptr;
   if (toggleDiagnosticsAction) delete toggleDiagnosticsAction;
   // if (this->pluginServer) delete this->pluginServer;
   diagnosticTextEdit = nullptr;
@@ -220,6 +259,12 @@ void MainWindow::writeSettings() {
   settings.endGroup();
 }
 
+void MainWindow::destroySubWindows() {
+  for (QMdiSubWindow *window : _ui->mdiArea->subWindowList()) {
+    if (window->close()) delete window;
+  }
+}
+
 void MainWindow::closeEvent(QCloseEvent *event) {
   _ui->mdiArea->closeAllSubWindows();
   this->writeSettings();
@@ -296,12 +341,15 @@ void MainWindow::openFile(QString fName) {
 
   MainWindow::setWindowTitle(fileInfo.fileName() + " - ENIGMA");
   _recentFiles->prependFile(fName);
+  _projectDirectory = fileInfo.absolutePath();
   openProject(std::move(loadedProject));
 }
 
 void MainWindow::openNewProject() {
   MainWindow::setWindowTitle(tr("<new game> - ENIGMA"));
-  auto newProject = std::make_unique<buffers::Project>();
+  _projectDirectory.clear();
+  auto arena = std::make_unique<google::protobuf::Arena>();
+  auto *newProject = google::protobuf::Arena::CreateMessage<buffers::Project>(arena.get());
   auto *root = newProject->mutable_game()->mutable_root();
   QList<QString> defaultGroups = {tr("Sprites"), tr("Sounds"),  tr("Backgrounds"), tr("Paths"),
                                   tr("Scripts"), tr("Shaders"), tr("Fonts"),       tr("Timelines"),
@@ -312,7 +360,7 @@ void MainWindow::openNewProject() {
     groupNode->set_name(groupName.toStdString());
     groupNode->mutable_folder();
   }
-  openProject(std::move(newProject));
+  openProject(std::move(arena), newProject);
 }
 
 template <typename Editor>
@@ -362,10 +410,23 @@ void ConfigureIconFields(ProtoModel::DisplayConfig *conf, const Descriptor *desc
 }
 
 void MainWindow::openProject(std::unique_ptr<buffers::Project> openedProject) {
-  this->_ui->mdiArea->closeAllSubWindows();
+  // The loaders hand us a heap-allocated project. Move it onto an arena so that everything allocated while editing
+  // comes from the arena too, and closing the project doesn't have to free each message individually.
+  auto arena = std::make_unique<google::protobuf::Arena>();
+  auto *project = google::protobuf::Arena::CreateMessage<buffers::Project>(arena.get());
+  project->Swap(openedProject.get());
+  openProject(std::move(arena), project);
+}
+
+void MainWindow::openProject(std::unique_ptr<google::protobuf::Arena> arena, buffers::Project *openedProject) {
+  destroySubWindows();
   ArtManager::clearCache();
 
-  _project = std::move(openedProject);
+  // The old models, and anyone listening to them, point into the old project's arena until they are replaced below.
+  // Keep it alive until the end of this function so their teardown doesn't read freed memory.
+  const std::unique_ptr<google::protobuf::Arena> oldArena = std::move(_projectArena);
+  _project = openedProject;
+  _projectArena = std::move(arena);
 
   TreeModel::DisplayConfig treeConf;
   treeConf.UseEditorLauncher<buffers::resources::Sprite>(Launch<SpriteEditor>(this));
@@ -420,42 +481,42 @@ void MainWindow::openProject(std::unique_ptr<buffers::Project> openedProject) {
   treeConf.SetMessagePassthrough<buffers::TreeNode::Folder>();
   treeConf.DisableOneofReassignment<buffers::TreeNode>();
 
+  // The tree reads from the old models, so it goes first. The old models unregister their references from the old map
+  // as they are destroyed, so the map is only replaced after them.
+  if (treeModel) delete treeModel;
+  treeModel = nullptr;
+  if (protoModel) delete protoModel;
   if (resourceMap) delete resourceMap;
   resourceMap = new ResourceModelMap(this);
 
-  if (protoModel) delete protoModel;
   protoModel = new MessageModel(ProtoModel::NonProtoParent{this}, _project->mutable_game()->mutable_root());
 
-  // Connect methods to auto update fields with extensions
-  connect(protoModel, &ProtoModel::ModelConstructed, [](ProtoModel *model) {
-    PrimitiveModel *primitive_model = model->TryCastAsPrimitiveModel();
-    if (primitive_model) {
-      const FieldDescriptor *const field = primitive_model->GetFieldDescriptor();
-      if (field && !field->options().GetExtension(buffers::resource_ref).empty())
-        connect(resourceMap,
-                qOverload<const std::string &, const QString &, const QString &>(&ResourceModelMap::ResourceRenamed),
-                primitive_model,
-                [primitive_model](const std::string &type, const QString &newValue, const QString &oldValue) {
-                  primitive_model->ExtensionChanged<decltype(buffers::resource_ref)>(buffers::resource_ref, type,
-                                                                                     newValue, oldValue);
-                });
-    }
-  });
-
+  // Fields with the resource_ref extension register themselves with resourceMap as they are constructed,
+  // which is how they are kept up to date when the resource they name is renamed or removed.
   protoModel->RebuildSubModels();
 
   protoModel->SetDisplayConfig(msgConf);
 
   resourceMap->TreeChanged(protoModel);
 
-  if (treeModel) delete treeModel;
+  if (!projectSnapshots) projectSnapshots = new ProjectSnapshots(this);
+  projectSnapshots->Track(_project, protoModel, resourceMap);
+  _projectSearch->Track(projectSnapshots, resourceMap);
+  _resourceNames->Track(resourceMap);
+
   treeModel = new TreeModel(protoModel, nullptr, treeConf);
 
   _ui->treeView->setModel(treeModel);
+  // Nodes are fetched as folders are expanded; drop them again once a folder has stayed collapsed.
+  connect(_ui->treeView, &QTreeView::collapsed, treeModel, [this](const QModelIndex &index) {
+    QPersistentModelIndex collapsed(index);
+    QTimer::singleShot(0, treeModel, [this, collapsed]() {
+      if (collapsed.isValid() && !_ui->treeView->isExpanded(collapsed)) treeModel->releaseChildren(collapsed);
+    });
+  });
   connect(treeModel, &TreeModel::ItemRenamed, resourceMap,
           qOverload<buffers::TreeNode::TypeCase, const QString &, const QString &>(&ResourceModelMap::ResourceRenamed));
-  connect(treeModel, &TreeModel::TreeChanged, resourceMap, &ResourceModelMap::TreeChanged);
-  connect(treeModel, &TreeModel::ItemRemoved, resourceMap, &ResourceModelMap::ResourceRemoved,
+  connect(treeModel, &TreeModel::ItemsRemoved, resourceMap, &ResourceModelMap::ResourcesRemoved,
           Qt::DirectConnection);
   connect(protoModel, &ProtoModel::dataChanged, resourceMap, &ResourceModelMap::dataChanged,
           Qt::DirectConnection);
@@ -495,7 +556,7 @@ void MainWindow::on_actionSave_triggered() {
     fileName.append(extensionMap[selectedFilter]);
   }
 
-  egm::WriteProject(_project.get(), fileName.toStdString());
+  egm::WriteProject(_project, fileName.toStdString());
 }
 
 void MainWindow::on_actionPreferences_triggered() {
@@ -574,13 +635,24 @@ void MainWindow::on_actionAbout_triggered() {
 }
 
 void MainWindow::on_treeView_doubleClicked(const QModelIndex &index) {
-  if (treeModel->rowCount(index)) {
+  if (treeModel->hasChildren(index)) {
     // Allow node expansion to happen.
     return;
   }
   treeModel->triggerNodeEdit(index, _ui->treeView);
 }
 
+void MainWindow::openResource(int type, const QString &name) {
+  MessageModel *node = resourceMap->GetResourceByName(type, name);
+  if (!node) return;
+  ProtoModel *list = node->GetParentModel<ProtoModel *>();
+  R_EXPECT_V(list) << "Resource" << name << "is not in the tree";
+  const QModelIndex index = treeModel->fetchFromSource(list->index(node->RowInParent()));
+  if (!index.isValid()) return;
+  _ui->treeView->setCurrentIndex(index);
+  treeModel->triggerNodeEdit(index, _ui->treeView);
+}
+
 void MainWindow::on_actionClearRecentMenu_triggered() { _recentFiles->clear(); }
 
 void MainWindow::CreateResource(TypeCase typeCase) {
@@ -602,28 +674,9 @@ void MainWindow::CreateResource(TypeCase typeCase) {
   QString resourceName = resourceMap->CreateResourceName(&child);
   child.set_name(resourceName.toStdString());
 
-  // release ownership of the new child to its parent and the tree
+  // release ownership of the new child to its parent and the tree; the resource map picks it up from the insertion
   auto index = this->treeModel->addNode(child, _ui->treeView->currentIndex());
   treeModel->triggerNodeEdit(index, _ui->treeView);
-
-  TreeModel::Node *node = this->treeModel->IndexToNode(index);
-  if(node == NULL){
-    qDebug() << "Attempt to add resource with NULL treeModel node...";
-    return;
-  }
-
-  ProtoModel *protoModel = node->BackingModel();
-  if(protoModel == NULL){
-    qDebug() << "Attempt to add resource with NULL protoModel...";
-    return;
-  }
-
-  MessageModel *messageModel = protoModel->TryCastAsMessageModel();
-  // add new resource with created name, helps in creating another unique name
-  if(messageModel)
-    resourceMap->AddResource(typeCase, resourceName, messageModel);
-  else
-    qDebug() << "Attempt to add resource with NULL messageModel...";
 }
 
 void MainWindow::ResourceModelDeleted(MessageModel *m) {
@@ -658,7 +711,12 @@ void MainWindow::on_actionCreateSettings_triggered() { CreateResource(TypeCase::
 void MainWindow::on_actionDuplicate_triggered() {
  // if (!_ui->treeView->selectionModel()->hasSelection()) return;
   const auto index = _ui->treeView->selectionModel()->currentIndex();
-  QModelIndex dupIndex = treeModel->duplicateNode(index);
+  TreeModel::Node *node = treeModel->IndexToNode(index);
+  if (!node || node->IsRepeated()) return;
+  // The copy and everything in it get fresh names, so no two resources end up sharing one.
+  TreeNode copy = node->GetMessage();
+  resourceMap->AssignUniqueNames(&copy);
+  QModelIndex dupIndex = treeModel->insert(index.parent(), node->row_in_model + 1, copy);
   // Triggers edit of either resource or name label.
   // TODO: maybe confirm before duplicating an entire fucking group; we're all reasonable people
   treeModel->triggerNodeEdit(dupIndex, _ui->treeView);
@@ -711,13 +769,21 @@ void MainWindow::on_actionDelete_triggered() {
   treeModel->BatchRemove(selectedNodes);
 }
 
-void MainWindow::on_actionExpand_triggered() { _ui->treeView->expandAll(); }
+void MainWindow::on_actionExpand_triggered() {
+  treeModel->fetchAll();
+  _ui->treeView->expandAll();
+}
 
 void MainWindow::on_actionCollapse_triggered() { _ui->treeView->collapseAll(); }
 
 void MainWindow::on_actionSortByName_triggered() {
   if (!_ui->treeView->selectionModel()->hasSelection()) return;
-  treeModel->sortByName(_ui->treeView->currentIndex());
+  treeModel->sortByName(_ui->treeView->currentIndex(), _ui->actionNaturalSortOrder->isChecked());
+}
+
+void MainWindow::on_actionSortByNameRecursively_triggered() {
+  if (!_ui->treeView->selectionModel()->hasSelection()) return;
+  treeModel->sortByName(_ui->treeView->currentIndex(), _ui->actionNaturalSortOrder->isChecked(), true);
 }
 
 void MainWindow::on_treeView_customContextMenuRequested(const QPoint &pos) {
@@ -1,12 +1,16 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include "Components/ProjectSearchIndex.h"
+#include "Components/ProjectSnapshots.h"
 #include "Models/ProtoModel.h"
 #include "Models/ResourceModelMap.h"
 #include "Models/TreeModel.h"
 #include "Editors/BaseEditor.h"
 
 class MainWindow;
+class FuzzyResourceIndex;
+class ProjectSearchDock;
 #include "Components/RecentFiles.h"
 
 #include "project.pb.h"
@@ -21,6 +25,8 @@ class MainWindow;
 #include <QProcess>
 #include <QFileInfo>
 
+#include <google/protobuf/arena.h>
+
 #ifndef ENIGMA_DIR
 #error "ENIGMA_DIR not defined"
 #endif
@@ -37,11 +43,14 @@ class MainWindow : public QMainWindow {
   static MessageModel* resourceModel;
   static TreeModel* treeModel;
   static MessageModel* protoModel;
+  static ProjectSnapshots* projectSnapshots;
   static QList<buffers::SystemType> systemCache;
 
   explicit MainWindow(QWidget *parent);
   ~MainWindow();
   void openProject(std::unique_ptr<buffers::Project> openedProject);
+  // Takes ownership of a project allocated on the given arena.
+  void openProject(std::unique_ptr<google::protobuf::Arena> arena, buffers::Project *openedProject);
   buffers::Game *Game() const { return this->_project->mutable_game(); }
 
   static QList<QString> EnigmaSearchPaths;
@@ -79,6 +88,7 @@ class MainWindow : public QMainWindow {
   void on_actionProperties_triggered();
   void on_actionDelete_triggered();
   void on_actionSortByName_triggered();
+  void on_actionSortByNameRecursively_triggered();
 
   // resources menu
   void on_actionCreateSprite_triggered();
@@ -118,6 +128,10 @@ class MainWindow : public QMainWindow {
 
  private:
   void closeEvent(QCloseEvent *event) override;
+  // Closes every editor and destroys the ones that agreed to close right away. Editors restore their backups as they
+  // are destroyed, which must happen while the models they edit are still alive; left to deleteLater, they would only
+  // go once control returns to the event loop.
+  void destroySubWindows();
 
   static MainWindow *_instance;
 
@@ -125,14 +139,23 @@ class MainWindow : public QMainWindow {
 
   Ui::MainWindow *_ui;
 
-  std::unique_ptr<buffers::Project> _project;
+  // The open project lives on its own arena, so closing it frees every message in one go.
+  std::unique_ptr<google::protobuf::Arena> _projectArena;
+  buffers::Project *_project = nullptr;
+  // The directory of the open project's file, which relative paths in it are relative to. Empty for a new project.
+  QString _projectDirectory;
   QPointer<RecentFiles> _recentFiles;
+  ProjectSearchIndex *_projectSearch;
+  ProjectSearchDock *_searchDock;
+  FuzzyResourceIndex *_resourceNames;
 
   static std::unique_ptr<EventData> _event_data;
 
   void readSettings();
   void writeSettings();
   void setTabbedMode(bool enabled);
+  // Reveals the resource in the tree and opens its editor.
+  void openResource(int type, const QString &name);
   static QFileInfo getEnigmaRoot();
 };
 
@@ -5,6 +5,8 @@
 #include "RepeatedPrimitiveModel.h"
 #include "ResourceModelMap.h"
 
+#include <google/protobuf/util/message_differencer.h>
+
 static constexpr int CCP_TYPE_ROLE = Qt::UserRole + 1;
 
 MessageModel::MessageModel(ProtoModel *parent, Message *protobuf, int row_in_parent)
@@ -71,73 +73,86 @@ bool MessageModel::IsCulledOneofRow(int row) const {
 }
 
 void MessageModel::RebuildSubModels() {
+  for (ProtoModel *submodel : qAsConst(submodels_by_row_)) {
+    if (submodel) DiscardSubModel(submodel);
+  }
   submodels_by_field_.clear();
   submodels_by_row_.clear();
   R_EXPECT_V(_protobuf) << "Internal protobuf null";
 
   const Descriptor *desc = _protobuf->GetDescriptor();
-  const Reflection *refl = _protobuf->GetReflection();
   submodels_by_row_.resize(desc->field_count());
 
   for (int i = 0; i < desc->field_count(); i++) {
-    const FieldDescriptor *field = desc->field(i);
+    if (ProtoModel *submodel = BuildSubModel(i))
+      submodels_by_field_[desc->field(i)->number()] = submodels_by_row_[i] = submodel;
+  }
+}
 
-    if (field->is_repeated()) {
-      switch (field->cpp_type()) {
-        case CppType::CPPTYPE_ENUM: {
-          qDebug() << "ENUMs not yet handled";
-          break;
-        }
-        case CppType::CPPTYPE_MESSAGE: {
-          submodels_by_field_[field->number()] = submodels_by_row_[i] = new RepeatedMessageModel(this, _protobuf, field);
-          break;
-        }
-        case CppType::CPPTYPE_BOOL: {
-          submodels_by_field_[field->number()] = submodels_by_row_[i] = new RepeatedBoolModel(this, _protobuf, field);
-          break;
-        }
-        case CppType::CPPTYPE_INT32: {
-          submodels_by_field_[field->number()] = submodels_by_row_[i] = new RepeatedInt32Model(this, _protobuf, field);
-          break;
-        }
-        case CppType::CPPTYPE_INT64: {
-          submodels_by_field_[field->number()] = submodels_by_row_[i] = new RepeatedInt64Model(this, _protobuf, field);
-          break;
-        }
-        case CppType::CPPTYPE_UINT32: {
-          submodels_by_field_[field->number()] = submodels_by_row_[i] = new RepeatedUInt32Model(this, _protobuf, field);
-          break;
-        }
-        case CppType::CPPTYPE_UINT64: {
-          submodels_by_field_[field->number()] = submodels_by_row_[i] = new RepeatedUInt64Model(this, _protobuf, field);
-          break;
-        }
-        case CppType::CPPTYPE_FLOAT: {
-          submodels_by_field_[field->number()] = submodels_by_row_[i] = new RepeatedFloatModel(this, _protobuf, field);
-          break;
-        }
-        case CppType::CPPTYPE_DOUBLE: {
-          submodels_by_field_[field->number()] = submodels_by_row_[i] = new RepeatedDoubleModel(this, _protobuf, field);
-          break;
-        }
-        case CppType::CPPTYPE_STRING: {
-          submodels_by_field_[field->number()] = submodels_by_row_[i] = new RepeatedStringModel(this, _protobuf, field);
-          break;
-        }
-      }
-    } else if (field->cpp_type() == CppType::CPPTYPE_MESSAGE) {
-      // Ignore all unset oneof fields if any is set
-      if (IsCulledOneof_(refl, *_protobuf, field)) continue;
-      // Only recursively build fields if they're set
-      if (refl->HasField(*_protobuf, field)) {
-        submodels_by_field_[field->number()] = submodels_by_row_[i] =
-            new MessageModel(this, refl->MutableMessage(_protobuf, field), i);
-      } else {
-        submodels_by_field_[field->number()] = submodels_by_row_[i] = new MessageModel(this, field->message_type(), i);
+void MessageModel::DiscardSubModel(ProtoModel *submodel) {
+  if (!submodel->IsRetired()) submodel->Retire();
+  submodel->deleteLater();
+}
+
+ProtoModel *MessageModel::BuildSubModel(int row) {
+  const FieldDescriptor *field = descriptor_->field(row);
+  const Reflection *refl = _protobuf->GetReflection();
+
+  if (field->is_repeated()) {
+    switch (field->cpp_type()) {
+      case CppType::CPPTYPE_ENUM: {
+        qDebug() << "ENUMs not yet handled";
+        return nullptr;
       }
-    } else {
-      submodels_by_field_[field->number()] = submodels_by_row_[i] = new PrimitiveModel(this, field);
+      case CppType::CPPTYPE_MESSAGE: return new RepeatedMessageModel(this, _protobuf, field);
+      case CppType::CPPTYPE_BOOL:    return new RepeatedBoolModel(this, _protobuf, field);
+      case CppType::CPPTYPE_INT32:   return new RepeatedInt32Model(this, _protobuf, field);
+      case CppType::CPPTYPE_INT64:   return new RepeatedInt64Model(this, _protobuf, field);
+      case CppType::CPPTYPE_UINT32:  return new RepeatedUInt32Model(this, _protobuf, field);
+      case CppType::CPPTYPE_UINT64:  return new RepeatedUInt64Model(this, _protobuf, field);
+      case CppType::CPPTYPE_FLOAT:   return new RepeatedFloatModel(this, _protobuf, field);
+      case CppType::CPPTYPE_DOUBLE:  return new RepeatedDoubleModel(this, _protobuf, field);
+      case CppType::CPPTYPE_STRING:  return new RepeatedStringModel(this, _protobuf, field);
     }
+    return nullptr;
+  }
+  if (field->cpp_type() == CppType::CPPTYPE_MESSAGE) {
+    // Ignore all unset oneof fields if any is set
+    if (IsCulledOneof_(refl, *_protobuf, field)) return nullptr;
+    // Only recursively build fields if they're set
+    if (refl->HasField(*_protobuf, field)) return new MessageModel(this, refl->MutableMessage(_protobuf, field), row);
+    return new MessageModel(this, field->message_type(), row);
+  }
+  return new PrimitiveModel(this, field);
+}
+
+void MessageModel::Retire() {
+  ProtoModel::Retire();
+  for (ProtoModel *submodel : qAsConst(submodels_by_row_)) {
+    if (submodel) submodel->Retire();
+  }
+  _protobuf = nullptr;
+}
+
+void MessageModel::Rebind(Message *protobuf, int row_in_parent) {
+  R_EXPECT_V(protobuf && protobuf->GetDescriptor() == descriptor_)
+      << "Cannot rebind" << DebugName() << "to a different message type";
+  Revive(row_in_parent);
+  _protobuf = protobuf;
+
+  for (int i = 0; i < submodels_by_row_.size(); ++i) {
+    const FieldDescriptor *field = descriptor_->field(i);
+    ProtoModel *&submodel = submodels_by_row_[i];
+    // Singular primitive submodels only know their field and row, so they carry over as they are.
+    // Everything else points into the old message and has to be rebuilt.
+    if (submodel && !field->is_repeated() && field->cpp_type() != CppType::CPPTYPE_MESSAGE) {
+      submodel->As<PrimitiveModel>()->Rebind(i);
+      continue;
+    }
+    if (submodel) DiscardSubModel(submodel);
+    submodel = BuildSubModel(i);
+    if (submodel) submodels_by_field_[field->number()] = submodel;
+    else submodels_by_field_.remove(field->number());
   }
 }
 
@@ -150,6 +165,7 @@ int MessageModel::rowCount(const QModelIndex &parent) const {
 int MessageModel::columnCount(const QModelIndex & /*parent*/) const { return 1; }
 
 bool MessageModel::setData(const QModelIndex &index, const QVariant &value, int role) {
+  R_EXPECT(_protobuf, false) << "Setting data on" << DebugName() << "which has no backing message";
   R_EXPECT(index.isValid(), false) << "Supplied index was invalid:" << index;
 
   const Descriptor *desc = _protobuf->GetDescriptor();
@@ -320,6 +336,7 @@ Qt::ItemFlags MessageModel::flags(const QModelIndex &index) const {
 
 MessageModel *MessageModel::BackupModel(QObject *parent) {
   if (!_protobuf) return nullptr;
+  // The project may live on an arena, but the backup is ours to free, so it goes on the heap (New without an arena).
   _backupProtobuf.reset(_protobuf->New());
   _backupProtobuf->CopyFrom(*_protobuf);
   _modelBackup = new MessageModel(NonProtoParent{parent}, _backupProtobuf.get());
@@ -329,13 +346,116 @@ MessageModel *MessageModel::BackupModel(QObject *parent) {
 
 MessageModel *MessageModel::GetBackupModel() { return _modelBackup; }
 
-void MessageModel::ReplaceBuffer(const Message *buffer) {
-  beginResetModel();
-  SetDirty(true);
-  _protobuf->CopyFrom(*buffer);
-  qDebug() << "Buffer replaced; rebuilding submodels";
-  RebuildSubModels();
-  endResetModel();
+static bool SingularFieldsEqual(const Reflection *refl, const Message &a, const Message &b,
+                                const FieldDescriptor *field) {
+  if (refl->HasField(a, field) != refl->HasField(b, field)) return false;
+  switch (field->cpp_type()) {
+    case CppType::CPPTYPE_MESSAGE:
+      return util::MessageDifferencer::Equals(refl->GetMessage(a, field), refl->GetMessage(b, field));
+    case CppType::CPPTYPE_INT32:  return refl->GetInt32(a, field) == refl->GetInt32(b, field);
+    case CppType::CPPTYPE_INT64:  return refl->GetInt64(a, field) == refl->GetInt64(b, field);
+    case CppType::CPPTYPE_UINT32: return refl->GetUInt32(a, field) == refl->GetUInt32(b, field);
+    case CppType::CPPTYPE_UINT64: return refl->GetUInt64(a, field) == refl->GetUInt64(b, field);
+    case CppType::CPPTYPE_DOUBLE: return refl->GetDouble(a, field) == refl->GetDouble(b, field);
+    case CppType::CPPTYPE_FLOAT:  return refl->GetFloat(a, field) == refl->GetFloat(b, field);
+    case CppType::CPPTYPE_BOOL:   return refl->GetBool(a, field) == refl->GetBool(b, field);
+    case CppType::CPPTYPE_ENUM:   return refl->GetEnumValue(a, field) == refl->GetEnumValue(b, field);
+    case CppType::CPPTYPE_STRING: return refl->GetString(a, field) == refl->GetString(b, field);
+  }
+  return false;
+}
+
+static void CopySingularField(const Reflection *refl, Message *to, const Message &from,
+                              const FieldDescriptor *field) {
+  if (!refl->HasField(from, field)) {
+    refl->ClearField(to, field);
+    return;
+  }
+  switch (field->cpp_type()) {
+    case CppType::CPPTYPE_MESSAGE:
+      refl->MutableMessage(to, field)->CopyFrom(refl->GetMessage(from, field));
+      break;
+    case CppType::CPPTYPE_INT32:  refl->SetInt32(to, field, refl->GetInt32(from, field)); break;
+    case CppType::CPPTYPE_INT64:  refl->SetInt64(to, field, refl->GetInt64(from, field)); break;
+    case CppType::CPPTYPE_UINT32: refl->SetUInt32(to, field, refl->GetUInt32(from, field)); break;
+    case CppType::CPPTYPE_UINT64: refl->SetUInt64(to, field, refl->GetUInt64(from, field)); break;
+    case CppType::CPPTYPE_DOUBLE: refl->SetDouble(to, field, refl->GetDouble(from, field)); break;
+    case CppType::CPPTYPE_FLOAT:  refl->SetFloat(to, field, refl->GetFloat(from, field)); break;
+    case CppType::CPPTYPE_BOOL:   refl->SetBool(to, field, refl->GetBool(from, field)); break;
+    case CppType::CPPTYPE_ENUM:   refl->SetEnumValue(to, field, refl->GetEnumValue(from, field)); break;
+    case CppType::CPPTYPE_STRING: refl->SetString(to, field, refl->GetString(from, field)); break;
+  }
+}
+
+bool MessageModel::HasStructuralDifference(const Message &buffer) const {
+  const Reflection *refl = _protobuf->GetReflection();
+  for (int i = 0; i < descriptor_->field_count(); ++i) {
+    const FieldDescriptor *field = descriptor_->field(i);
+    if (field->is_repeated() || field->cpp_type() != CppType::CPPTYPE_MESSAGE) continue;
+    if (refl->HasField(*_protobuf, field) != refl->HasField(buffer, field)) return true;
+    if (IsCulledOneof_(refl, *_protobuf, field) != IsCulledOneof_(refl, buffer, field)) return true;
+  }
+  return false;
+}
+
+static bool RepeatedEnumsEqual(const Reflection *refl, const Message &a, const Message &b,
+                               const FieldDescriptor *field) {
+  const int size = refl->FieldSize(a, field);
+  if (size != refl->FieldSize(b, field)) return false;
+  for (int i = 0; i < size; ++i) {
+    if (refl->GetRepeatedEnumValue(a, field, i) != refl->GetRepeatedEnumValue(b, field, i)) return false;
+  }
+  return true;
+}
+
+bool MessageModel::ReplaceBuffer(const Message *buffer) {
+  R_EXPECT(_protobuf && buffer, false) << "Cannot replace the buffer of" << DebugName() << "with a null message";
+  R_EXPECT(buffer->GetDescriptor() == descriptor_, false)
+      << "Cannot replace the buffer of" << DebugName() << "with a" << buffer->GetDescriptor()->full_name().c_str();
+
+  // Submessages coming or going (including oneof reassignment) changes which submodels exist.
+  // Views can't be told about that with row signals, so only this message is reset.
+  if (HasStructuralDifference(*buffer)) {
+    SetDirty(true);
+    beginResetModel();
+    _protobuf->CopyFrom(*buffer);
+    RebuildSubModels();
+    endResetModel();
+    return true;
+  }
+
+  // Each field is compared exactly once, by the submodel that owns it; nested messages report back whether anything
+  // in them changed, so no subtree is compared again on the way up.
+  bool changed = false;
+  const Reflection *refl = _protobuf->GetReflection();
+  for (int row = 0; row < descriptor_->field_count(); ++row) {
+    const FieldDescriptor *field = descriptor_->field(row);
+    ProtoModel *submodel = submodels_by_row_[row];
+    if (field->is_repeated()) {
+      if (RepeatedModel *repeated = submodel ? submodel->TryCastAsRepeatedModel() : nullptr) {
+        changed |= repeated->ReplaceField(*buffer);
+      } else if (!RepeatedEnumsEqual(refl, *_protobuf, *buffer, field)) {
+        // Repeated enums have no model; copy them wholesale.
+        refl->ClearField(_protobuf, field);
+        for (int i = 0; i < refl->FieldSize(*buffer, field); ++i)
+          refl->AddEnumValue(_protobuf, field, refl->GetRepeatedEnumValue(*buffer, field, i));
+        emit DataChanged(index(row), index(row));
+        changed = true;
+      }
+    } else if (field->cpp_type() == CppType::CPPTYPE_MESSAGE) {
+      // Unset on both sides (checked above) means there is nothing to do.
+      if (!refl->HasField(*buffer, field)) continue;
+      if (MessageModel *message = submodel ? submodel->TryCastAsMessageModel() : nullptr)
+        changed |= message->ReplaceBuffer(&refl->GetMessage(*buffer, field));
+    } else if (!SingularFieldsEqual(refl, *_protobuf, *buffer, field)) {
+      const QVariant oldValue = data(index(row));
+      CopySingularField(refl, _protobuf, *buffer, field);
+      emit DataChanged(index(row), index(row), oldValue);
+      changed = true;
+    }
+  }
+  if (changed) SetDirty(true);
+  return changed;
 }
 
 bool MessageModel::RestoreBackup() {
@@ -23,6 +23,11 @@ class MessageModel : public ProtoModel {
   // refrences to to the submodels it owns recursively must be updated
   void RebuildSubModels();
 
+  // Points a retired model (see ProtoModelPool) at a new message of the same type, sitting at the given row.
+  // Singular primitive submodels are kept; submodels which point into the message itself are rebuilt.
+  void Rebind(Message *protobuf, int row_in_parent);
+  void Retire() override;
+
   // All editor changes are made instantly rather than on confirm.
   // Whenever an editor is spawned a copy of the underlying protobuf is made.
   // In the event the user opts to close the editor and undo their changes this backup is restored.
@@ -76,7 +81,10 @@ class MessageModel : public ProtoModel {
 
   // These are the same as the above but operate on the raw protobuf
   Message *GetBuffer();
-  void ReplaceBuffer(const Message *buffer);
+  // Makes our protobuf a copy of the given buffer. Only fields which actually differ are touched; each change is
+  // announced through dataChanged (or row insert/remove for repeated fields), and submodels are kept wherever possible.
+  // Returns whether anything differed.
+  bool ReplaceBuffer(const Message *buffer);
   // Does the fastest possible conversion from field to QString. Returns empty for message fields.
   QString FastGetQString(const FieldDescriptor *field) const;
 
@@ -100,6 +108,15 @@ class MessageModel : public ProtoModel {
   MessageModel *TryCastAsMessageModel() override { return this; }
 
  protected:
+  // Returns true if assigning `buffer` would set or clear a submessage (or select a different oneof member).
+  // Such changes alter which submodels exist, so they can't be expressed as plain row signals.
+  bool HasStructuralDifference(const Message &buffer) const;
+  // Constructs the submodel for the given row, or returns null if that row has none (e.g. a culled oneof member).
+  ProtoModel *BuildSubModel(int row);
+  // Retires a submodel this message no longer uses, so it stops listening and stops being counted as a reference
+  // site right away, and deletes it once control returns to the event loop.
+  static void DiscardSubModel(ProtoModel *submodel);
+
   google::protobuf::Message *_protobuf;
   MessageModel *_modelBackup = nullptr;
   QScopedPointer<Message> _backupProtobuf;
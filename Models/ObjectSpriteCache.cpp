@@ -0,0 +1,84 @@
+#include "Models/ObjectSpriteCache.h"
+#include "Components/ArtManager.h"
+#include "Models/RepeatedMessageModel.h"
+
+ObjectSpriteCache::ObjectSpriteCache(ResourceModelMap* resources) : QObject(resources), _resources(resources) {
+  // Entries resolved before their subimage was decoded have no pixmap yet.
+  connect(ArtManager::Loader(), &ArtLoader::PixmapLoaded, this, [this](const QString& image) {
+    for (ResourceId object : _awaiting.values(image)) Invalidate(object);
+  });
+  // The models of a removed resource are retired (dropping our watchers) and may come back for a different resource,
+  // so pointer comparisons can't be trusted past this point.
+  connect(resources, &ResourceModelMap::ResourceUnindexed, this, [this](MessageModel* node) {
+    for (ResourceId object : _users.values(node)) Invalidate(object);
+  });
+}
+
+ObjectSpriteCache::Entry ObjectSpriteCache::Placeholder() {
+  Entry entry;
+  entry.image = "object";
+  entry.pixmap = ArtManager::GetCachedPixmap(entry.image);
+  return entry;
+}
+
+const ObjectSpriteCache::Entry& ObjectSpriteCache::Resolve(ResourceId object) {
+  static const Entry placeholder = Placeholder();
+  if (object < 0) return placeholder;
+  if (object >= _slots.size()) _slots.resize(object + 1);
+
+  MessageModel* objectNode = _resources->GetResourceById(object);
+  Slot& slot = _slots[object];
+  // Renames and deletions rebind ids without touching the models we watch, so check the bindings are still the same.
+  if (slot.resolved && slot.objectNode == objectNode && slot.spriteNode == _resources->GetResourceById(slot.sprite))
+    return slot.entry;
+
+  Invalidate(object);
+  slot.resolved = true;
+  slot.objectNode = objectNode;
+  slot.sprite = ResourceModelMap::kNoResource;
+  slot.spriteNode = nullptr;
+  slot.entry = placeholder;
+  if (objectNode) _users.insert(objectNode, object);
+
+  MessageModel* obj = objectNode ? objectNode->GetSubModel<MessageModel*>(TreeNode::kObjectFieldNumber) : nullptr;
+  if (!obj) return slot.entry;
+  Watch(slot, object, obj);
+
+  const QString spriteName = obj->Data(FieldPath::Of<Object>(Object::kSpriteNameFieldNumber)).toString();
+  slot.sprite = _resources->InternName(TreeNode::kSprite, spriteName);
+  slot.spriteNode = _resources->GetResourceById(slot.sprite);
+  if (!slot.spriteNode) return slot.entry;
+  _users.insert(slot.spriteNode, object);
+  MessageModel* spr = slot.spriteNode->GetSubModel<MessageModel*>(TreeNode::kSpriteFieldNumber);
+  if (!spr) return slot.entry;
+  Watch(slot, object, spr);
+
+  if (spr->GetSubModel<RepeatedStringModel*>(Sprite::kSubimagesFieldNumber)->Empty()) return slot.entry;
+  Entry& entry = slot.entry;
+  entry.image =
+      spr->Data(FieldPath::Of<Sprite>(FieldPath::RepeatedOffset(Sprite::kSubimagesFieldNumber, 0))).toString();
+  entry.pixmap = ArtManager::FindCachedPixmap(entry.image);
+  if (entry.pixmap.isNull()) _awaiting.insert(entry.image, object);
+  entry.width = spr->Data(FieldPath::Of<Sprite>(Sprite::kWidthFieldNumber)).toInt();
+  entry.height = spr->Data(FieldPath::Of<Sprite>(Sprite::kHeightFieldNumber)).toInt();
+  entry.originX = spr->Data(FieldPath::Of<Sprite>(Sprite::kOriginXFieldNumber)).toInt();
+  entry.originY = spr->Data(FieldPath::Of<Sprite>(Sprite::kOriginYFieldNumber)).toInt();
+  return entry;
+}
+
+void ObjectSpriteCache::Watch(Slot& slot, ResourceId object, ProtoModel* model) {
+  // Changes anywhere below the model (e.g. a subimage being added) bubble up to it as dataChanged.
+  slot.watchers.append(connect(model, &ProtoModel::dataChanged, this, [this, object]() { Invalidate(object); }));
+  slot.watchers.append(connect(model, &ProtoModel::modelReset, this, [this, object]() { Invalidate(object); }));
+}
+
+void ObjectSpriteCache::Invalidate(ResourceId object) {
+  Slot& slot = _slots[object];
+  if (slot.objectNode) _users.remove(slot.objectNode, object);
+  if (slot.spriteNode) _users.remove(slot.spriteNode, object);
+  _awaiting.remove(slot.entry.image, object);
+  slot.objectNode = slot.spriteNode = nullptr;
+  slot.resolved = false;
+  for (const auto& watcher : qAsConst(slot.watchers)) disconnect(watcher);
+  slot.watchers.clear();
+}
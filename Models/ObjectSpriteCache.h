@@ -0,0 +1,52 @@
+#ifndef OBJECTSPRITECACHE_H
+#define OBJECTSPRITECACHE_H
+
+#include "Models/ResourceModelMap.h"
+
+#include <QMultiHash>
+#include <QPixmap>
+#include <QVector>
+
+// Remembers how each object is drawn in a room: which sprite it resolves to, that sprite's first subimage and the
+// geometry needed to place it. Entries are keyed by interned object id and are dropped as soon as the object's
+// sprite_name or anything in the sprite changes, or either resource goes away or is renamed. Removal is heard from the
+// resource map rather than detected by comparing models, since a removed resource's models can be reused for another.
+class ObjectSpriteCache : public QObject {
+  Q_OBJECT
+
+ public:
+  using ResourceId = ResourceModelMap::ResourceId;
+
+  struct Entry {
+    QString image;  // First subimage of the sprite, or the generic object icon when there's no sprite to draw.
+    QPixmap pixmap;
+    int width = 16, height = 16;
+    int originX = 0, originY = 0;
+  };
+
+  explicit ObjectSpriteCache(ResourceModelMap* resources);
+
+  // The returned entry is only valid until the next call.
+  const Entry& Resolve(ResourceId object);
+
+ private:
+  struct Slot {
+    Entry entry;
+    bool resolved = false;
+    MessageModel* objectNode = nullptr;
+    ResourceId sprite = ResourceModelMap::kNoResource;
+    MessageModel* spriteNode = nullptr;
+    QList<QMetaObject::Connection> watchers;
+  };
+
+  void Invalidate(ResourceId object);
+  void Watch(Slot& slot, ResourceId object, ProtoModel* model);
+  static Entry Placeholder();
+
+  ResourceModelMap* _resources;
+  QVector<Slot> _slots;  // By object id.
+  QMultiHash<const MessageModel*, ResourceId> _users;  // The objects whose entry depends on each resolved resource.
+  QMultiHash<QString, ResourceId> _awaiting;  // The objects whose entry lacks each image, until it is decoded.
+};
+
+#endif  // OBJECTSPRITECACHE_H
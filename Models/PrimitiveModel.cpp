@@ -12,6 +12,26 @@ PrimitiveModel::PrimitiveModel(MessageModel *parent, const FieldDescriptor *fiel
     emit p->ModelConstructed(this);
     p = p->GetParentModel<ProtoModel*>();
   }
+  if (MainWindow::resourceMap && !ReferencedResourceType().isEmpty()) MainWindow::resourceMap->AddReference(this);
+}
+
+PrimitiveModel::~PrimitiveModel() {
+  if (MainWindow::resourceMap && !IsRetired()) MainWindow::resourceMap->RemoveReference(this);
+}
+
+void PrimitiveModel::Retire() {
+  if (MainWindow::resourceMap) MainWindow::resourceMap->RemoveReference(this);
+  ProtoModel::Retire();
+}
+
+void PrimitiveModel::Rebind(int row_in_parent) {
+  Revive(row_in_parent);
+  if (MainWindow::resourceMap && !ReferencedResourceType().isEmpty()) MainWindow::resourceMap->AddReference(this);
+}
+
+QString PrimitiveModel::ReferencedResourceType() const {
+  if (!field_or_null_) return {};
+  return QString::fromStdString(field_or_null_->options().GetExtension(buffers::resource_ref));
 }
 
 const ProtoModel *PrimitiveModel::GetSubModel(const FieldPath &field_path) const {
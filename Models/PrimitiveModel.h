@@ -17,9 +17,14 @@ class PrimitiveModel : public ProtoModel {
       : ProtoModel(parent, parent->GetDescriptor()->name(), parent->GetDescriptor(), row_in_parent),
         field_or_null_(nullptr) {}
   PrimitiveModel(MessageModel *parent, const FieldDescriptor *field);
+  ~PrimitiveModel() override;
 
   bool Empty() { return rowCount() == 0; }
 
+  // Puts a retired model (see ProtoModelPool) back to work at the given row of the same parent.
+  void Rebind(int row_in_parent);
+  void Retire() override;
+
   using ProtoModel::Data;
   using ProtoModel::SetData;
   QVariant Data() const override {
@@ -58,6 +63,8 @@ class PrimitiveModel : public ProtoModel {
 
   const FieldDescriptor *GetRowDescriptor(int row) const override;
   const FieldDescriptor *GetFieldDescriptor() const { return field_or_null_; }
+  // The resource type named by this field's resource_ref option, or empty if the field doesn't refer to a resource.
+  QString ReferencedResourceType() const;
 
 
   QString GetDisplayName() const override;
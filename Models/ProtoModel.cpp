@@ -23,13 +23,20 @@ ProtoModel::ProtoModel(ProtoModel *parent, std::string name, const Descriptor *d
       descriptor_(descriptor),
       live_pointers_(parent ? parent->live_pointers_ : std::make_shared<std::set<const ProtoModel*>>()) {
   live_pointers_->insert(this);
+  ConnectInternalSignals();
+}
+
+void ProtoModel::ConnectInternalSignals() {
   connect(this, &ProtoModel::DataChanged, this,
           [this](const QModelIndex &topLeft, const QModelIndex &bottomRight,
                  const QVariant & /*oldValue*/ = QVariant(0), const QVector<int> &roles = QVector<int>()) {
             emit QAbstractItemModel::dataChanged(topLeft, bottomRight, roles);
           });
-  if (parent) {
-    connect(this, &ProtoModel::dataChanged, this, [this](const QModelIndex&, const QModelIndex&, const QVector<int>&) {
+  if (_parentModel) {
+    connect(this, &ProtoModel::dataChanged, this,
+            [this](const QModelIndex&, const QModelIndex&, const QVector<int>& roles) {
+      // A thumbnail finishing loading doesn't change anything the parent holds.
+      if (roles.size() == 1 && roles.front() == Qt::DecorationRole) return;
       auto me = _parentModel->index(row_in_parent_);
       emit _parentModel->dataChanged(me, me, {});
     });
@@ -41,10 +48,34 @@ ProtoModel::ProtoModel(ProtoModel *parent, std::string name, const Descriptor *d
 }
 
 ProtoModel::~ProtoModel() {
+  if (retired_) return;
   if (auto me = live_pointers_->find(this); me == live_pointers_->end()) qDebug() << "CRITICAL: Double-free!";
   else live_pointers_->erase(me);
 }
 
+void ProtoModel::Retire() {
+  R_EXPECT_V(!retired_) << "Retiring" << DebugName() << "twice";
+  disconnect();
+  live_pointers_->erase(this);
+  retired_ = true;
+}
+
+void ProtoModel::Revive(int row_in_parent) {
+  R_EXPECT_V(retired_) << "Reviving" << DebugName() << "which was never retired";
+  retired_ = false;
+  row_in_parent_ = row_in_parent;
+  live_pointers_->insert(this);
+  ConnectInternalSignals();
+}
+
+void ProtoModel::Reparent(ProtoModel *parent, int row_in_parent) {
+  R_EXPECT_V(parent && parent->live_pointers_ == live_pointers_)
+      << "Cannot move" << DebugName() << "out of the tree it belongs to";
+  QObject::setParent(parent);
+  _parentModel = parent;
+  row_in_parent_ = row_in_parent;
+}
+
 void ProtoModel::ParentDataChanged() {
   ProtoModel *m = GetParentModel<ProtoModel *>();
   while (m != nullptr) {
@@ -346,6 +346,14 @@ class ProtoModel : public QAbstractItemModel {
   void SetDisplayConfig(const DisplayConfig &display_config);
   ~ProtoModel() override;
 
+  // Pooling support. A retired model no longer backs any data: its signals are disconnected and it is dropped from
+  // the live pointer set until it is revived to back a new row. See ProtoModelPool.
+  virtual void Retire();
+  bool IsRetired() const { return retired_; }
+  // Moves this model under another parent in the same tree, at the given row. The protobuf data it views must already
+  // have been moved there without copying, so that this model and its submodels still point at it.
+  void Reparent(ProtoModel *parent, int row_in_parent);
+
 signals:
   // QAbstractItemModel has a datachanged signal but it doesn't store the old values
   // We use old values in some places to revert invalid changes.
@@ -355,6 +363,10 @@ signals:
   void DataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVariant &oldValue = QVariant(0),
                    const QVector<int> &roles = QVector<int>());
   void ModelConstructed(ProtoModel* model);
+  // A repeated model removing several ranges at once announces them as one layout change. These tell listeners which
+  // rows go: RowsAboutToBeDropped is emitted for each range while its rows are still there, and RowsDropped after.
+  void RowsAboutToBeDropped(int first, int last);
+  void RowsDropped();
 
  protected:
   /// Allows child classes to change row_in_parent_ when swapping their own submodels.
@@ -364,6 +376,9 @@ signals:
     std::swap(left->row_in_parent_, right->row_in_parent_);
   }
 
+  /// Puts a retired model back to work at the given row of its (unchanged) parent.
+  void Revive(int row_in_parent);
+
   bool _dirty;
   ProtoModel *_parentModel;
   int row_in_parent_;
@@ -374,6 +389,10 @@ signals:
   std::shared_ptr<std::set<ProtoModel const*>> live_pointers_;
 
  private:
+  // Hooks our own signals up to dataChanged and to our parent. Redone on revival, since retiring disconnects them.
+  void ConnectInternalSignals();
+
+  bool retired_ = false;
    static DisplayConfig display_config_;
 };
 
@@ -0,0 +1,69 @@
+#ifndef PROTOMODELPOOL_H
+#define PROTOMODELPOOL_H
+
+#include "ProtoModel.h"
+
+#include <QTimer>
+#include <QVector>
+
+// Running totals of the work done by all pools of one model type. Useful for profiling editor churn.
+struct ProtoModelPoolCounters {
+  quint64 allocated = 0;  ///< Rows which had to construct a fresh model because their pool was empty.
+  quint64 reused = 0;     ///< Rows which were handed a recycled model instead.
+  quint64 released = 0;   ///< Models returned to a pool when the row they backed went away.
+  quint64 discarded = 0;  ///< Released models that were deleted because their pool was already full.
+};
+
+// Recycle list for the per-row submodels of one repeated field model.
+// Every model in a pool shares the same parent and descriptor, so recycling one only means pointing it at a new row.
+// Released models are retired immediately, but they only become available for reuse once control returns to the event
+// loop. That is the same grace period deleteLater gave to anyone still holding on to them.
+template <typename ModelT>
+class ProtoModelPool {
+ public:
+  static constexpr int kMaxPooledModels = 256;
+
+  explicit ProtoModelPool(QObject *owner): owner_(owner) {}
+
+  static ProtoModelPoolCounters &Counters() {
+    static ProtoModelPoolCounters counters;
+    return counters;
+  }
+
+  // Returns a retired model for the caller to revive, or nullptr if the caller has to construct a new one.
+  ModelT *Acquire() {
+    if (ready_.isEmpty()) {
+      ++Counters().allocated;
+      return nullptr;
+    }
+    ++Counters().reused;
+    return ready_.takeLast();
+  }
+
+  // Retires the given model and keeps it for reuse, or schedules it for deletion if the pool is full.
+  void Release(ModelT *model) {
+    model->Retire();
+    ++Counters().released;
+    if (ready_.size() + pending_.size() >= kMaxPooledModels) {
+      ++Counters().discarded;
+      model->deleteLater();
+      return;
+    }
+    pending_.append(model);
+    if (flush_scheduled_) return;
+    flush_scheduled_ = true;
+    QTimer::singleShot(0, owner_, [this]() {
+      ready_ += pending_;
+      pending_.clear();
+      flush_scheduled_ = false;
+    });
+  }
+
+ private:
+  QObject *owner_;
+  QVector<ModelT *> pending_;
+  QVector<ModelT *> ready_;
+  bool flush_scheduled_ = false;
+};
+
+#endif
@@ -2,15 +2,26 @@
 #include "RepeatedMessageModel.h"
 #include "MessageModel.h"
 
+#include <google/protobuf/util/message_differencer.h>
+
 RepeatedMessageModel::RepeatedMessageModel(ProtoModel *parent, Message *message, const FieldDescriptor *field)
     : BasicRepeatedModel<Message>(parent, message, field,
-                             message->GetReflection()->GetMutableRepeatedFieldRef<Message>(message, field)) {
+                             message->GetReflection()->GetMutableRepeatedFieldRef<Message>(message, field)),
+      pool_(this) {
   const Reflection *refl = _protobuf->GetReflection();
   for (int j = 0; j < refl->FieldSize(*_protobuf, field); j++) {
     _subModels.append(new MessageModel(this, refl->MutableRepeatedMessage(_protobuf, field, j), j));
   }
 }
 
+MessageModel *RepeatedMessageModel::AcquireSubModel(Message *message, int row) {
+  if (MessageModel *model = pool_.Acquire()) {
+    model->Rebind(message, row);
+    return model;
+  }
+  return new MessageModel(this, message, row);
+}
+
 void RepeatedMessageModel::SwapWithoutSignal(int left, int right) {
   R_EXPECT_V(left != right) << "Swapping same element";
   BasicRepeatedModel<Message>::SwapWithoutSignal(left, right);
@@ -20,27 +31,83 @@ void RepeatedMessageModel::SwapWithoutSignal(int left, int right) {
 void RepeatedMessageModel::AppendNewWithoutSignal() {
   auto refl = _protobuf->GetReflection();
   auto m = refl->AddMessage(_protobuf, field_);
-  _subModels.append(new MessageModel(this, m, _subModels.size()));
+  _subModels.append(AcquireSubModel(m, _subModels.size()));
+}
+
+void RepeatedMessageModel::AppendWithoutSignal(const Message &message) {
+  auto refl = _protobuf->GetReflection();
+  auto m = refl->AddMessage(_protobuf, field_);
+  m->CopyFrom(message);
+  _subModels.append(AcquireSubModel(m, _subModels.size()));
+}
+
+bool RepeatedMessageModel::ReplaceField(const Message &source) {
+  const Reflection *refl = source.GetReflection();
+  const int old_size = rowCount(), new_size = refl->FieldSize(source, field_);
+
+  // Nothing can have been inserted or removed, so every row is diffed in place and compared exactly once.
+  if (old_size == new_size) {
+    bool changed = false;
+    for (int row = 0; row < old_size; ++row)
+      changed |= _subModels[row]->ReplaceBuffer(&refl->GetRepeatedMessage(source, field_, row));
+    return changed;
+  }
+
+  auto unchanged = [&](int old_row, int new_row) {
+    return util::MessageDifferencer::Equals(*_subModels[old_row]->GetBuffer(),
+                                            refl->GetRepeatedMessage(source, field_, new_row));
+  };
+
+  // Trim the common prefix and suffix so that a single insertion or deletion only touches the rows involved.
+  // Rows found equal here aren't visited again, and comparing a changed row stops at its first difference.
+  int prefix = 0, suffix = 0;
+  while (prefix < old_size && prefix < new_size && unchanged(prefix, prefix)) ++prefix;
+  while (suffix < old_size - prefix && suffix < new_size - prefix &&
+         unchanged(old_size - 1 - suffix, new_size - 1 - suffix)) ++suffix;
+  const int old_middle = old_size - prefix - suffix, new_middle = new_size - prefix - suffix;
+
+  // Rows present on both sides are diffed in place, keeping their models.
+  for (int row = prefix; row < prefix + std::min(old_middle, new_middle); ++row)
+    _subModels[row]->ReplaceBuffer(&refl->GetRepeatedMessage(source, field_, row));
+
+  if (new_middle > old_middle) {
+    const int first = prefix + old_middle, count = new_middle - old_middle;
+    beginInsertRows(QModelIndex(), first, first + count - 1);
+    const int p = rowCount();
+    for (int i = 0; i < count; ++i) AppendWithoutSignal(refl->GetRepeatedMessage(source, field_, first + i));
+    SwapBackWithoutSignal(first, p, rowCount());
+    ParentDataChanged();
+    endInsertRows();
+  } else if (old_middle > new_middle) {
+    const int first = prefix + new_middle, count = old_middle - new_middle;
+    beginRemoveRows(QModelIndex(), first, first + count - 1);
+    SwapBackWithoutSignal(first, first + count, rowCount());
+    RemoveLastNRowsWithoutSignal(count);
+    ParentDataChanged();
+    endRemoveRows();
+  }
+  return true;
 }
 
 void RepeatedMessageModel::RemoveLastNRowsWithoutSignal(int n) {
   R_EXPECT_V(n <= field_ref_.size())
       << "Trying to remove " << n << " rows from a " << field_ref_.size() << "-row message field.";
   BasicRepeatedModel<Message>::RemoveLastNRowsWithoutSignal(n);
-  size_t idx = _subModels.size() - n;
-  for (int i = 0; i < n; ++i) {
-    _subModels.at(idx)->disconnect();
-    _subModels.at(idx)->deleteLater();
-    idx++;
-  }
+  for (int i = _subModels.size() - n; i < _subModels.size(); ++i) pool_.Release(_subModels[i]);
   _subModels.resize(_subModels.size() - n);
 }
 
-void RepeatedMessageModel::ClearWithoutSignal() {
-  for (auto& model : _subModels) {
-    model->disconnect();
+void RepeatedMessageModel::Retire() {
+  BasicRepeatedModel<Message>::Retire();
+  for (MessageModel *model : qAsConst(_subModels)) {
+    model->Retire();
     model->deleteLater();
   }
+  _subModels.clear();
+}
+
+void RepeatedMessageModel::ClearWithoutSignal() {
+  for (MessageModel *model : qAsConst(_subModels)) pool_.Release(model);
   field_ref_.Clear();
   _subModels.clear();
 }
@@ -52,28 +119,76 @@ bool RepeatedMessageModel::setData(const QModelIndex &index, const QVariant &val
 }
 
 QModelIndex RepeatedMessageModel::insert(const Message &message, int row) {
-  R_EXPECT(row <= rowCount(), QModelIndex()) <<  "Insert message failed";
+  R_EXPECT(InsertRows(row, std::vector<const Message *>{&message}), QModelIndex()) << "Insert message failed";
+  return createIndex(row, 0, this);
+}
 
-  beginInsertRows(QModelIndex(), row, row);
+bool RepeatedMessageModel::InsertRows(int row, const std::vector<const Message *> &messages) {
+  if (messages.empty()) return true;
+  R_EXPECT(row >= 0 && row <= rowCount(), false) << "Cannot insert at row " << row << " of " << DebugName();
+
+  beginInsertRows(QModelIndex(), row, row + messages.size() - 1);
 
   int p = rowCount();
 
-  // Append new row to the list, then move it backwards to where it's supposed to be inserted.
-  AppendNewWithoutSignal();
+  // Append copies of the messages to the list, then rotate them backwards to where they're supposed to be inserted.
+  for (const Message *message : messages) AppendWithoutSignal(*message);
   SwapBackWithoutSignal(row, p, rowCount());
 
-  // Overwrite default-initialized message with the one we are inserting.
-  auto m = GetSubModel(row);
-  R_EXPECT(m, QModelIndex()) << "Requested submodel is null";
-  MessageModel* mm = m->TryCastAsMessageModel();
-  R_EXPECT(mm, QModelIndex()) << "Failed to cast to message model";
-  mm->ReplaceBuffer(&message);
-
   ParentDataChanged();
 
   endInsertRows();
 
-  return createIndex(row, 0, this);
+  return true;
+}
+
+bool RepeatedMessageModel::CanMoveRowsTo(const RepeatedMessageModel *destination) const {
+  return destination && destination->field_->message_type() == field_->message_type() &&
+         destination->_protobuf->GetArena() == _protobuf->GetArena();
+}
+
+bool RepeatedMessageModel::MoveRowsTo(int row, int count, RepeatedMessageModel *destination, int destination_row) {
+  if (count <= 0) return true;
+  if (destination == this) return moveRows(row, count, destination_row);
+  R_EXPECT(CanMoveRowsTo(destination), false) << "Cannot move rows of" << DebugName() << "without copying them";
+  R_EXPECT(row >= 0 && row + count <= rowCount(), false)
+      << "Rows " << row << " through " << row + count - 1 << " of " << DebugName() << " are out of bounds";
+  R_EXPECT(destination_row >= 0 && destination_row <= destination->rowCount(), false)
+      << "Cannot move rows to row " << destination_row << " of " << destination->DebugName();
+
+  // Both fields live on the same arena (or both on the heap), so releasing and adding back only moves pointers.
+  const bool on_arena = _protobuf->GetArena() != nullptr;
+  const Reflection *refl = _protobuf->GetReflection();
+  const Reflection *destination_refl = destination->_protobuf->GetReflection();
+  std::vector<Message *> messages;
+  QVector<MessageModel *> models;
+
+  beginRemoveRows(QModelIndex(), row, row + count - 1);
+  SwapBackWithoutSignal(row, row + count, rowCount());
+  for (int i = 0; i < count; ++i) {
+    messages.push_back(on_arena ? refl->UnsafeArenaReleaseLast(_protobuf, field_)
+                                : refl->ReleaseLast(_protobuf, field_));
+    models.append(_subModels.takeLast());
+  }
+  ParentDataChanged();
+  endRemoveRows();
+
+  destination->beginInsertRows(QModelIndex(), destination_row, destination_row + count - 1);
+  const int p = destination->rowCount();
+  // Released last to first; add them back in their original order.
+  for (int i = count - 1; i >= 0; --i) {
+    if (on_arena)
+      destination_refl->UnsafeArenaAddAllocatedMessage(destination->_protobuf, destination->field_, messages[i]);
+    else
+      destination_refl->AddAllocatedMessage(destination->_protobuf, destination->field_, messages[i]);
+    models[i]->Reparent(destination, destination->_subModels.size());
+    destination->_subModels.append(models[i]);
+  }
+  destination->SwapBackWithoutSignal(destination_row, p, destination->rowCount());
+  destination->ParentDataChanged();
+  destination->endInsertRows();
+
+  return true;
 }
 
 QModelIndex RepeatedMessageModel::duplicate(const QModelIndex &message) {
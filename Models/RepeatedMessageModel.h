@@ -2,6 +2,7 @@
 #define REPEATEDMESSAGEMODEL_H
 
 #include "RepeatedPrimitiveModel.h"
+#include "ProtoModelPool.h"
 
 class RepeatedMessageModel : public BasicRepeatedModel<Message> {
   Q_OBJECT
@@ -31,8 +32,14 @@ class RepeatedMessageModel : public BasicRepeatedModel<Message> {
 
   void SwapWithoutSignal(int /*left*/, int /*right*/) override;
   void AppendNewWithoutSignal() override;
+  // Adds a copy of the given message to the end of the list. Does not emit data change signals.
+  void AppendWithoutSignal(const Message &message);
   void RemoveLastNRowsWithoutSignal(int /*newSize*/) override;
   void ClearWithoutSignal() override;
+  bool ReplaceField(const Message &source) override;
+  // Retires every row along with the list. A retired list is never revived (its message rebuilds it when rebound), so
+  // the rows are deleted rather than kept around with their subtrees.
+  void Retire() override;
 
   using ProtoModel::Data;
   using ProtoModel::SetData;
@@ -54,6 +61,17 @@ class RepeatedMessageModel : public BasicRepeatedModel<Message> {
 
   /// Inserts the given message as a child at the given row.
   QModelIndex insert(const Message &message, int row);
+  /// Inserts copies of the given messages, in order, starting at the given row.
+  /// Rows are added and rotated into place in a single pass and announced with a single insert signal.
+  using RepeatedModel::InsertRows;
+  bool InsertRows(int row, const std::vector<const Message *> &messages);
+  /// Returns whether rows of this field can be handed to the given field by MoveRowsTo().
+  /// That requires the same message type and the same arena (or none), so that protobuf never has to copy them.
+  bool CanMoveRowsTo(const RepeatedMessageModel *destination) const;
+  /// Moves `count` rows starting at `row` into `destination` before `destination_row`, without copying any data.
+  /// The messages change owners and their submodels are reparented, so anyone holding one keeps a valid model.
+  /// Announced as a removal from this model and an insertion into the destination. Use moveRows() within one field.
+  bool MoveRowsTo(int row, int count, RepeatedMessageModel *destination, int destination_row);
   /// Duplicates the child at the given index. Returns the index of the new (duplicate) node.
   QModelIndex duplicate(const QModelIndex &message);
   // TODO: implement dropping a message
@@ -62,7 +80,11 @@ class RepeatedMessageModel : public BasicRepeatedModel<Message> {
   //const QModelIndex &parent) override;
 
  protected:
+  // Hands out a model for the given element, recycling a retired one when possible.
+  MessageModel *AcquireSubModel(Message *message, int row);
+
   QVector<MessageModel *> _subModels;
+  ProtoModelPool<MessageModel> pool_;
 };
 
 #endif
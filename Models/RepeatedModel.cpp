@@ -7,6 +7,7 @@
 #include <QMimeData>
 
 #include <algorithm>
+#include <numeric>
 
 bool RepeatedModel::setData(const QModelIndex& index, const QVariant& value, int /*role*/) {
   if (index.column() != 0) {
@@ -31,13 +32,31 @@ QVariant RepeatedModel::data(const QModelIndex& index, int role) const {
     case Qt::DisplayRole: return GetDirect(index.row());
     case Qt::DecorationRole: {
       auto* model = GetSubModel(index.row());
-      if (model) return model->GetDisplayIcon();
-      else return {};
+      if (!model) return {};
+      // Rows showing image files (sprite subimages, instances) get thumbnails made in the background, not on paint.
+      ArtManager::DeferredLoads loads;
+      QIcon icon = model->GetDisplayIcon();
+      if (!loads.Pending().isEmpty()) {
+        for (const QString& name : loads.Pending()) awaited_icons_.insert(name);
+        if (!icon_loads_) {
+          auto* self = const_cast<RepeatedModel*>(this);
+          icon_loads_ = connect(ArtManager::Loader(), &ArtLoader::IconLoaded, self,
+                                [self](const QString& name) { self->IconLoaded(name); });
+        }
+      }
+      return icon;
     }
     default: return QVariant();
   }
 }
 
+void RepeatedModel::IconLoaded(const QString& name) {
+  if (!awaited_icons_.remove(name)) return;
+  if (awaited_icons_.isEmpty()) disconnect(icon_loads_);
+  if (IsRetired() || rowCount() == 0) return;
+  emit dataChanged(index(0), index(rowCount() - 1), {Qt::DecorationRole});
+}
+
 const ProtoModel *RepeatedModel::GetSubModel(const FieldPath &field_path) const {
   if (!field_path.fields.empty()) {
     qDebug() << "Attempting to access sub-field `" << field_path.front()->full_name().c_str()
@@ -151,22 +170,112 @@ bool RepeatedModel::insertRows(int row, int count, const QModelIndex &parent) {
 
 bool RepeatedModel::removeRows(int position, int count, const QModelIndex& parent) {
   Q_UNUSED(parent);
-  RowRemovalOperation remover(this);
-  remover.RemoveRows(position, count);
+  if (count <= 0) return false;
+  RemoveRows({RowRange(position, position + count - 1)});
+  return true;
+}
+
+bool RepeatedModel::InsertRows(int row, const QVector<QVariant> &values) {
+  if (values.isEmpty()) return true;
+  R_EXPECT(row >= 0 && row <= rowCount(), false) << "Cannot insert at row " << row << " of " << DebugName();
+
+  beginInsertRows(QModelIndex(), row, row + values.size() - 1);
+
+  int p = rowCount();
+
+  // Append all of the rows, then rotate them backward to where they were supposed to be inserted in one go.
+  for (const QVariant &value : values) {
+    AppendNewWithoutSignal();
+    SetDirect(rowCount() - 1, value);
+  }
+  SwapBackWithoutSignal(row, p, rowCount());
+  ParentDataChanged();
+
+  endInsertRows();
+
   return true;
 }
 
+void RepeatedModel::RemoveRows(const std::vector<RowRange> &ranges) {
+  if (ranges.empty()) return;
+  R_EXPECT_V(ranges.front().first >= 0 && ranges.back().last < rowCount())
+      << "Rows " << ranges.front().first << " through " << ranges.back().last << " are out of bounds ("
+      << rowCount() << " rows total)";
+
+  if (ranges.size() == 1) {
+    const RowRange &range = ranges.front();
+    beginRemoveRows(QModelIndex(), range.first, range.last);
+    // Rotate the rows behind the range in front of it, then drop it off the end.
+    SwapBackWithoutSignal(range.first, range.last + 1, rowCount());
+    RemoveLastNRowsWithoutSignal(range.size());
+    endRemoveRows();
+    ParentDataChanged();
+    return;
+  }
+
+  // Removing the ranges one at a time would move the rows behind each of them again and again. Instead, every
+  // surviving row is moved forward once, over the gaps, and the removed rows all drop off the end together.
+  for (auto range = ranges.rbegin(); range != ranges.rend(); ++range) {
+    emit RowsAboutToBeDropped(range->first, range->last);
+  }
+  emit layoutAboutToBeChanged({}, VerticalSortHint);
+  const int rows = rowCount();
+  std::vector<int> where(rows);
+  std::iota(where.begin(), where.begin() + ranges.front().first, 0);
+  int write = ranges.front().first, removed = 0;
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    for (int row = ranges[i].first; row <= ranges[i].last; ++row) where[row] = -1;
+    removed += ranges[i].size();
+    const int end = i + 1 < ranges.size() ? ranges[i + 1].first : rows;
+    for (int row = ranges[i].last + 1; row < end; ++row) {
+      SwapWithoutSignal(write, row);
+      where[row] = write++;
+    }
+  }
+  RemoveLastNRowsWithoutSignal(removed);
+  const QModelIndexList persistent = persistentIndexList();
+  for (const QModelIndex &index : persistent) {
+    const int row = where[index.row()];
+    changePersistentIndex(index, row < 0 ? QModelIndex() : this->index(row, index.column()));
+  }
+  emit layoutChanged({}, VerticalSortHint);
+  emit RowsDropped();
+  ParentDataChanged();
+}
+
+void RepeatedModel::PermuteRows(const std::vector<int> &order) {
+  R_EXPECT_V(order.size() == size_t(rowCount()))
+      << "Permuting " << order.size() << " rows of a " << rowCount() << "-row field";
+
+  emit layoutAboutToBeChanged({}, VerticalSortHint);
+  // at[row] is the original row now found at `row`; where[original] is the inverse.
+  std::vector<int> at(order.size()), where(order.size());
+  std::iota(at.begin(), at.end(), 0);
+  std::iota(where.begin(), where.end(), 0);
+  for (int row = 0; row < int(order.size()); ++row) {
+    const int from = where[order[row]];
+    if (from == row) continue;
+    SwapWithoutSignal(row, from);
+    where[at[row]] = from;
+    std::swap(at[row], at[from]);
+    where[at[row]] = row;
+  }
+  // Every original row has landed at where[original].
+  const QModelIndexList persistent = persistentIndexList();
+  for (const QModelIndex &index : persistent)
+    changePersistentIndex(index, this->index(where[index.row()], index.column()));
+  emit layoutChanged({}, VerticalSortHint);
+  ParentDataChanged();
+}
+
 RepeatedModel::RowRemovalOperation::~RowRemovalOperation() {
   if (rows_.empty()) return;
 
+  std::sort(rows_.begin(), rows_.end());
+  rows_.erase(std::unique(rows_.begin(), rows_.end()), rows_.end());
+
   // Compute ranges for our deleted rows.
-  struct Range {
-    int first, last;
-    Range() : first(), last() {}
-    Range(int f, int l) : first(f), last(l) {}
-    int size() { return last - first + 1; }
-  };
-  std::vector<Range> ranges;
+  std::vector<RowRange> ranges;
   for (int row : rows_) {
     if (ranges.empty() || row != ranges.back().last + 1) {
       ranges.emplace_back(row, row);
@@ -175,45 +284,7 @@ RepeatedModel::RowRemovalOperation::~RowRemovalOperation() {
     }
   }
 
-  // Basic dense range removal. Move "deleted" rows to the end of the array.
-  int left = 0, right = 0;
-  int expected_range_size = 0;
-  for (auto range : ranges) {
-    emit model_.beginRemoveRows(QModelIndex(), range.first, range.last);
-
-    if (right > left) {
-      while (right < range.first) {
-        model_.SwapWithoutSignal(left, right);
-        left++;
-        right++;
-      }
-    } else if (left <= range.first) {
-      left = range.first;
-    } else {
-      qDebug() << "Logic error: left pointer (" << left << ") is ahead of next range ("
-               << range.first << ", " << range.last << ")...";
-    }
-    right = range.last + 1;
-    expected_range_size += range.size();
-
-    emit model_.endRemoveRows();
-  }
-  while (right < model_.rowCount()) {
-    model_.SwapWithoutSignal(left, right);
-    left++;
-    right++;
-  }
-
-  const int actual_removal_size = model_.rowCount() - left;
-  if (expected_range_size != actual_removal_size) {
-    qDebug() << "Expected to remove " << expected_range_size
-             << " rows, but " << actual_removal_size << " rows are scheduled for removal";
-  }
-  if (actual_removal_size > 0 && actual_removal_size <= model_.rowCount()) {
-    model_.RemoveLastNRowsWithoutSignal(actual_removal_size);
-  }
-
-  model_.ParentDataChanged();
+  model_.RemoveRows(ranges);
 }
 
 // Mimedata stuff required for Drag & Drop and clipboard functions
@@ -285,13 +356,8 @@ bool RepeatedModel::dropMimeData(const QMimeData* data, Qt::DropAction action, i
     newItems << text;
   }
 
-  qDebug() << "State before insert: " << DataDebugString();
-  insertRows(beginRow, newItems.size(), QModelIndex());
-  qDebug() << "State after insert, before overwrite: " << DataDebugString();
-  foreach (const QString& text, newItems) {
-    SetDirect(beginRow++, text);
-  }
-  qDebug() << "State after overwrite: " << DataDebugString();
-
-  return true;
+  QVector<QVariant> values;
+  values.reserve(newItems.size());
+  for (const QString &text : qAsConst(newItems)) values.append(text);
+  return InsertRows(beginRow, values);
 }
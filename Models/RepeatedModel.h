@@ -9,6 +9,8 @@
 #include <google/protobuf/reflection.h>
 #include <google/protobuf/repeated_field.h>
 
+#include <QSet>
+
 // Model representing a repeated field. Do not instantiate an object of this class directly
 class RepeatedModel : public ProtoModel {
  public:
@@ -69,6 +71,11 @@ class RepeatedModel : public ProtoModel {
   // Clears all data in the underlying model. Does not emit data change signals.
   virtual void ClearWithoutSignal() = 0;
 
+  // Makes this field a copy of the same field in `source` (a message of our parent's type). Rows that are unchanged
+  // are left alone; changed rows emit dataChanged and any difference in length is announced as inserted/removed rows.
+  // Returns whether anything differed.
+  virtual bool ReplaceField(const Message &source) = 0;
+
   // Directly update the given row with the given value. The caller will have performed bounds checking.
   // Type checking (and conversion, where possible) is on the implementer.
   virtual bool SetDirect(int row, const QVariant &value) = 0;
@@ -103,6 +110,29 @@ class RepeatedModel : public ProtoModel {
   bool moveRows(int source, int count, int destination);
   bool insertRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
   bool removeRows(int position, int count, const QModelIndex& parent = QModelIndex()) override;
+
+  // ===================================================================================================================
+  // == Bulk operations ================================================================================================
+  // ===================================================================================================================
+
+  /// An inclusive range of rows.
+  struct RowRange {
+    int first, last;
+    RowRange(int f, int l) : first(f), last(l) {}
+    int size() const { return last - first + 1; }
+  };
+
+  /// Inserts one row per value, starting at `row`. The new rows are appended and rotated into place in a single pass,
+  /// and announced with a single insert signal.
+  bool InsertRows(int row, const QVector<QVariant> &values);
+  /// Removes the given ranges, which must be sorted and non-overlapping. A single range is announced as removed rows.
+  /// Several are compacted in one pass, so each surviving row moves at most once, and announced as a single layout
+  /// change: RowsAboutToBeDropped is emitted for each range first, back to front, and RowsDropped once they are gone.
+  /// Prefer RowRemovalOperation when the rows are not already grouped.
+  void RemoveRows(const std::vector<RowRange> &ranges);
+  /// Moves the row at order[i] to row i for every i, swapping each row into place at most once. Announced as a single
+  /// layout change; persistent indexes follow their rows.
+  void PermuteRows(const std::vector<int> &order);
   QMimeData *mimeData(const QModelIndexList &indexes) const override;
   bool dropMimeData(const QMimeData *data, Qt::DropAction action, int row, int column,
                     const QModelIndex &parent) override;
@@ -114,9 +144,9 @@ class RepeatedModel : public ProtoModel {
 
   class RowRemovalOperation {
    public:
-    void RemoveRow(int row) { rows_.insert(row); }
+    void RemoveRow(int row) { rows_.push_back(row); }
     void RemoveRows(int row, int count) {
-      for (int i = row; i < row + count; ++i) rows_.insert(i);
+      for (int i = row; i < row + count; ++i) rows_.push_back(i);
     }
     void RemoveRows(const QModelIndexList& indexes) {
       foreach (auto index, indexes)
@@ -132,13 +162,22 @@ class RepeatedModel : public ProtoModel {
     ~RowRemovalOperation();
 
    private:
-    std::set<int> rows_;
+    // Sorted and deduplicated on completion.
+    std::vector<int> rows_;
     RepeatedModel &model_;
   };
 
  protected:
   Message *_protobuf;
   const FieldDescriptor *field_;
+
+ private:
+  // Repaints the decorations of all rows if any of them showed a placeholder for the given icon.
+  void IconLoaded(const QString &name);
+
+  // Icons which rows showed a placeholder for, and the connection waiting on them while there are any.
+  mutable QSet<QString> awaited_icons_;
+  mutable QMetaObject::Connection icon_loads_;
 };
 
 // Model representing a repeated field. Do not instantiate an object of this class directly
@@ -3,6 +3,7 @@
 
 #include "RepeatedModel.h"
 #include "PrimitiveModel.h"
+#include "ProtoModelPool.h"
 
 template <typename T>
 class RepeatedPrimitiveModel : public BasicRepeatedModel<T> {
@@ -28,7 +29,65 @@ class RepeatedPrimitiveModel : public BasicRepeatedModel<T> {
   // Need to implement this in all RepeatedModels
   void AppendNewWithoutSignal() final {
     BasicRepeatedModel<T>::field_ref_.Add({});
-    submodels_.push_back(new PrimitiveModel(this, BasicRepeatedModel<T>::field_ref_.size() - 1));
+    const int row = BasicRepeatedModel<T>::field_ref_.size() - 1;
+    if (PrimitiveModel *model = pool_.Acquire()) {
+      model->Rebind(row);
+      submodels_.push_back(model);
+    } else {
+      submodels_.push_back(new PrimitiveModel(this, row));
+    }
+  }
+
+  void RemoveLastNRowsWithoutSignal(int n) override {
+    BasicRepeatedModel<T>::RemoveLastNRowsWithoutSignal(n);
+    while (submodels_.size() > BasicRepeatedModel<T>::field_ref_.size()) pool_.Release(submodels_.takeLast());
+  }
+
+  void ClearWithoutSignal() override {
+    BasicRepeatedModel<T>::ClearWithoutSignal();
+    for (PrimitiveModel *model : qAsConst(submodels_)) pool_.Release(model);
+    submodels_.clear();
+  }
+
+  bool ReplaceField(const Message &source) override {
+    MutableRepeatedFieldRef<T> &field_ref = BasicRepeatedModel<T>::field_ref_;
+    const RepeatedFieldRef<T> other = source.GetReflection()->GetRepeatedFieldRef<T>(source, this->field_);
+    const int old_size = field_ref.size(), new_size = other.size();
+
+    int first_changed = -1, last_changed = -1;
+    for (int i = 0; i < std::min(old_size, new_size); ++i) {
+      if (field_ref.Get(i) == other.Get(i)) continue;
+      field_ref.Set(i, other.Get(i));
+      if (first_changed == -1) first_changed = i;
+      last_changed = i;
+    }
+    if (first_changed != -1) emit this->DataChanged(this->index(first_changed, 0), this->index(last_changed, 0));
+
+    if (new_size > old_size) {
+      this->beginInsertRows(QModelIndex(), old_size, new_size - 1);
+      for (int i = old_size; i < new_size; ++i) {
+        AppendNewWithoutSignal();
+        field_ref.Set(i, other.Get(i));
+      }
+      this->ParentDataChanged();
+      this->endInsertRows();
+    } else if (new_size < old_size) {
+      this->beginRemoveRows(QModelIndex(), new_size, old_size - 1);
+      this->RemoveLastNRowsWithoutSignal(old_size - new_size);
+      this->ParentDataChanged();
+      this->endRemoveRows();
+    }
+    return first_changed != -1 || new_size != old_size;
+  }
+
+  // Retires every row along with the list, which is never revived; see RepeatedMessageModel::Retire.
+  void Retire() override {
+    BasicRepeatedModel<T>::Retire();
+    for (PrimitiveModel *model : qAsConst(submodels_)) {
+      model->Retire();
+      model->deleteLater();
+    }
+    submodels_.clear();
   }
 
   void RebuildSubModels() {
@@ -46,6 +105,7 @@ class RepeatedPrimitiveModel : public BasicRepeatedModel<T> {
 
  private:
   QVector<PrimitiveModel*> submodels_;
+  ProtoModelPool<PrimitiveModel> pool_{this};
 };
 
 #define RGM_DECLARE_REPEATED_PRIMITIVE_MODEL(ModelName, model_type)                     \
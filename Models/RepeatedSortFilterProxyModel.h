@@ -10,10 +10,12 @@
 class RepeatedSortFilterProxyModel : public QSortFilterProxyModel {
  public:
   RepeatedSortFilterProxyModel(QObject *parent);
-  void SetSourceModel(RepeatedModel *sourceModel);
+  virtual void SetSourceModel(RepeatedModel *sourceModel);
   QVariant Data(FieldPath field_path) const;
   QVariant DataOrDefault(FieldPath field_path, const QVariant def = QVariant()) const;
   ProtoModel* GetSubModel(int fieldNum) const;
+  // Maps a row of this proxy to the corresponding row of the source model.
+  int SourceRow(int row) const { return mapToSource(index(row, 0)).row(); }
 
 protected:
   void setSourceModel(QAbstractItemModel* /*sourceModel*/) override {}
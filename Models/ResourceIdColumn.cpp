@@ -0,0 +1,67 @@
+#include "Models/ResourceIdColumn.h"
+#include "MainWindow.h"
+#include "Models/RepeatedMessageModel.h"
+
+#include <algorithm>
+
+ResourceIdColumn::ResourceIdColumn(int resourceType, int fieldNumber, QObject* parent)
+    : QObject(parent), _type(resourceType), _field(fieldNumber) {
+  // Renames rewrite the referring fields with signals blocked, so the model itself never tells us about them.
+  if (!MainWindow::resourceMap) return;
+  connect(MainWindow::resourceMap,
+          qOverload<const std::string&, const QString&, const QString&>(&ResourceModelMap::ResourceRenamed), this,
+          [this]() { Rebuild(); });
+}
+
+void ResourceIdColumn::SetSourceModel(RepeatedMessageModel* rows) {
+  for (const auto& connection : qAsConst(_connections)) disconnect(connection);
+  _connections.clear();
+  _rows = rows;
+  _descriptor = rows ? rows->GetFieldDescriptor()->message_type()->FindFieldByNumber(_field) : nullptr;
+  Rebuild();
+  if (!_rows) return;
+
+  _connections.append(connect(_rows, &ProtoModel::rowsInserted, this, [this](const QModelIndex&, int first, int last) {
+    _ids.insert(first, last - first + 1, ResourceModelMap::kNoResource);
+    Refresh(first, last);
+  }));
+  _connections.append(connect(_rows, &ProtoModel::rowsRemoved, this, [this](const QModelIndex&, int first, int last) {
+    _ids.remove(first, last - first + 1);
+  }));
+  _connections.append(connect(_rows, &ProtoModel::rowsMoved, this, [this]() { Rebuild(); }));
+  _connections.append(connect(_rows, &ProtoModel::modelReset, this, [this]() { Rebuild(); }));
+  _connections.append(connect(_rows, &ProtoModel::layoutChanged, this, [this]() { Rebuild(); }));
+  _connections.append(
+      connect(_rows, &ProtoModel::dataChanged, this, [this](const QModelIndex& topLeft, const QModelIndex& bottomRight) {
+        Refresh(topLeft.row(), bottomRight.row());
+      }));
+}
+
+ResourceIdColumn::ResourceId ResourceIdColumn::IdAt(int row) const {
+  return row >= 0 && row < _ids.size() ? _ids[row] : ResourceModelMap::kNoResource;
+}
+
+MessageModel* ResourceIdColumn::NodeAt(int row) const { return MainWindow::resourceMap->GetResourceById(IdAt(row)); }
+
+MessageModel* ResourceIdColumn::ResourceAt(int row) const {
+  MessageModel* node = NodeAt(row);
+  // TreeNode's type cases are the field numbers of the resource messages they hold.
+  return node ? node->GetSubModel<MessageModel*>(_type) : nullptr;
+}
+
+ResourceIdColumn::ResourceId ResourceIdColumn::Lookup(int row) const {
+  const MessageModel* element = _rows->GetSubModel<MessageModel*>(row);
+  if (!element || !_descriptor) return ResourceModelMap::kNoResource;
+  return MainWindow::resourceMap->InternName(_type, element->Data(FieldPath(_descriptor)).toString());
+}
+
+void ResourceIdColumn::Refresh(int first, int last) {
+  first = std::max(first, 0);
+  last = std::min(last, _ids.size() - 1);
+  for (int row = first; row <= last; ++row) _ids[row] = Lookup(row);
+}
+
+void ResourceIdColumn::Rebuild() {
+  _ids.fill(ResourceModelMap::kNoResource, _rows ? _rows->rowCount() : 0);
+  Refresh(0, _ids.size() - 1);
+}
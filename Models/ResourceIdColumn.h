@@ -0,0 +1,45 @@
+#ifndef RESOURCEIDCOLUMN_H
+#define RESOURCEIDCOLUMN_H
+
+#include "Models/ResourceModelMap.h"
+
+#include <QObject>
+#include <QVector>
+
+class RepeatedMessageModel;
+
+// Caches the interned id of the resource named by one field of every row in a repeated message, such as the object of
+// each instance in a room. Painters and sort comparators can then resolve the resource of a row with two vector reads.
+class ResourceIdColumn : public QObject {
+  Q_OBJECT
+
+ public:
+  using ResourceId = ResourceModelMap::ResourceId;
+
+  // The type is the TreeNode type case of the resource, and the field number belongs to the repeated message.
+  ResourceIdColumn(int resourceType, int fieldNumber, QObject* parent);
+
+  // Must be set before anything else (e.g. a sort proxy) starts listening to the same model, so ids are current by
+  // the time the others hear about a change.
+  void SetSourceModel(RepeatedMessageModel* rows);
+
+  ResourceId IdAt(int row) const;
+  // Returns the resource message itself (e.g. the Object), not the tree node holding it.
+  MessageModel* ResourceAt(int row) const;
+  // Returns the tree node of the resource, as GetResourceByName would.
+  MessageModel* NodeAt(int row) const;
+
+ private:
+  ResourceId Lookup(int row) const;
+  void Refresh(int first, int last);
+  void Rebuild();
+
+  int _type;
+  int _field;
+  const google::protobuf::FieldDescriptor* _descriptor = nullptr;
+  RepeatedMessageModel* _rows = nullptr;
+  QVector<ResourceId> _ids;
+  QList<QMetaObject::Connection> _connections;
+};
+
+#endif  // RESOURCEIDCOLUMN_H
@@ -1,8 +1,11 @@
 #include "Models/ResourceModelMap.h"
 #include "Editors/BaseEditor.h"
 #include "MainWindow.h"
+#include "Models/ObjectSpriteCache.h"
 #include "Models/RepeatedMessageModel.h"
 
+#include <functional>
+
 static std::string ResTypeAsString(TypeCase type) {
   switch (type) {
     case TypeCase::kFolder: return "treenode";
@@ -24,138 +27,391 @@ static std::string ResTypeAsString(TypeCase type) {
   return "unknown";
 }
 
-ResourceModelMap::ResourceModelMap(QObject* parent) : QObject(parent) {}
-
-static void TreeChangedHelper(MessageModel* model, ResourceModelMap* rm) {
-  const MessageModel* folder = model->GetSubModel<MessageModel*>(TreeNode::kFolderFieldNumber);
-  if (folder) {
-    const RepeatedMessageModel* children =
-        folder->GetSubModel<RepeatedMessageModel*>(TreeNode::Folder::kChildrenFieldNumber);
-    if (children) {
-      for (int i = 0; i < children->rowCount(); ++i) {
-        TreeChangedHelper(children->GetSubModel(i)->TryCastAsMessageModel(), rm);
-      }
-    }
-  } else {
-    int type = model->OneOfType("type");
-    rm->AddResource((buffers::TreeNode::TypeCase)type,
-                    model->Data(FieldPath::Of<TreeNode>(TreeNode::kNameFieldNumber)).toString(), model);
-  }
-}
+ResourceModelMap::ResourceModelMap(QObject* parent) : QObject(parent), _objectSprites(new ObjectSpriteCache(this)) {}
 
 void ResourceModelMap::dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles) {
   emit DataChanged();
 }
 
 void ResourceModelMap::TreeChanged(MessageModel* model) {
+  for (const WatchedFolder& folder : qAsConst(_folders)) {
+    for (const auto& connection : folder.self) disconnect(connection);
+    for (const auto& connection : folder.contents) disconnect(connection);
+  }
+  _folders.clear();
+  _folderTypes.clear();
   _resources.clear();
-  TreeChangedHelper(model, this);
+  _resourceKeys.clear();
+  _resourcesById.fill(nullptr);
+  _nameCounters.clear();
+  IndexSubtree(model);
 }
 
 void ResourceModelMap::AddResource(TypeCase type, const QString& name, MessageModel* model) {
   R_EXPECT_V(!_resources[type].contains(name))
       << "Resource" << ResTypeAsString(type) << "with name:" << name << "already exists";
   _resources[type][name] = model;
+  _resourceKeys[model] = {type, name};
+  BindId(type, name, model);
+  CountType(model, type, 1);
+  emit ResourceIndexed(model);
 }
 
-void ResourceModelMap::ResourceRemoved(TypeCase type, const QString& name,
-                                      std::map<ProtoModel*, RepeatedMessageModel::RowRemovalOperation>& removers) {
-  if (type == TypeCase::kFolder || !_resources.contains(type)) return;
-  if (!_resources[type].contains(name)) return;
-
-  // Delete all instances of this object type
-  if (type == TypeCase::kObject) {
-    for (auto& room : qAsConst(_resources[TypeCase::kRoom])) {
-      R_EXPECT_V(room);
-      MessageModel* roomModel = room->GetSubModel<MessageModel*>(TreeNode::kRoomFieldNumber);
-      R_EXPECT_V(roomModel);
-      RepeatedMessageModel* instancesModel = roomModel->GetSubModel<RepeatedMessageModel*>(Room::kInstancesFieldNumber);
-      auto& remover = removers.emplace(instancesModel, instancesModel).first->second;
-
-      for (int row = 0; row < instancesModel->rowCount(); ++row) {
-        if (instancesModel
-                ->Data(
-                    FieldPath::Of<Room::Instance>(FieldPath::StartingAt(row), Room::Instance::kObjectTypeFieldNumber))
-                .toString() == name)
-          remover.RemoveRow(row);
-      }
-
-      // Only models in use in open editors should have backup models
-      MessageModel* backupModel = roomModel->GetBackupModel();
-      if (backupModel != nullptr) {
-        RepeatedMessageModel* instancesModelBak =
-            backupModel->GetSubModel<RepeatedMessageModel*>(Room::kInstancesFieldNumber);
-        auto& remover = removers.emplace(instancesModelBak, instancesModelBak).first->second;
-
-        for (int row = 0; row < instancesModelBak->rowCount(); ++row) {
-          if (instancesModelBak
-                  ->Data(
-                      FieldPath::Of<Room::Instance>(FieldPath::StartingAt(row), Room::Instance::kObjectTypeFieldNumber))
-                  .toString() == name)
-            remover.RemoveRow(row);
-        }
-      }
+void ResourceModelMap::RemoveResource(MessageModel* model) {
+  auto key = _resourceKeys.find(model);
+  if (key == _resourceKeys.end()) return;
+  emit ResourceUnindexed(model);
+  CountType(model, key->type, -1);
+  auto byType = _resources.find(key->type);
+  if (byType != _resources.end()) {
+    auto byName = byType->find(key->name);
+    if (byName != byType->end() && *byName == model) {
+      byType->erase(byName);
+      BindId(key->type, key->name, nullptr);
+      ReleaseName(key->type, key->name);
     }
   }
+  _resourceKeys.erase(key);
+}
+
+void ResourceModelMap::CountType(const ProtoModel* node, int type, int delta) {
+  bool changed = false;
+  for (const ProtoModel* ancestor = node->GetParentModel(); ancestor; ancestor = ancestor->GetParentModel()) {
+    auto folder = _folderTypes.find(ancestor);
+    if (folder == _folderTypes.end()) continue;
+    if (folder->size() <= type) folder->resize(type + 1);
+    int& count = (*folder)[type];
+    changed |= (count == 0) != (count + delta == 0);
+    count += delta;
+  }
+  if (changed) emit TypePresenceChanged(type);
+}
+
+bool ResourceModelMap::ResourceKeyOf(MessageModel* node, int* type, QString* name) const {
+  auto key = _resourceKeys.find(node);
+  if (key == _resourceKeys.end()) return false;
+  *type = key->type;
+  *name = key->name;
+  return true;
+}
+
+bool ResourceModelMap::ContainsType(const ProtoModel* node, int type) const {
+  auto folder = _folderTypes.find(node);
+  if (folder != _folderTypes.end()) return type == TypeCase::kFolder || folder->value(type) > 0;
+  auto key = _resourceKeys.find(const_cast<ProtoModel*>(node)->TryCastAsMessageModel());
+  return key != _resourceKeys.end() && key->type == type;
+}
+
+ResourceModelMap::ResourceId ResourceModelMap::InternName(int type, const QString& name) {
+  if (name.isEmpty()) return kNoResource;
+  auto& ids = _nameIds[type];
+  auto it = ids.find(name);
+  if (it != ids.end()) return *it;
+  const ResourceId id = _resourcesById.size();
+  ids.insert(name, id);
+  _resourcesById.append(_resources.value(type).value(name));
+  return id;
+}
+
+void ResourceModelMap::BindId(int type, const QString& name, MessageModel* model) {
+  // Names nobody has asked for an id yet are bound when they are first interned.
+  auto ids = _nameIds.find(type);
+  if (ids == _nameIds.end()) return;
+  auto id = ids->find(name);
+  if (id != ids->end()) _resourcesById[*id] = model;
+}
+
+static RepeatedMessageModel* FolderChildren(MessageModel* node) {
+  const MessageModel* folder = node->GetSubModel<MessageModel*>(TreeNode::kFolderFieldNumber);
+  return folder ? folder->GetSubModel<RepeatedMessageModel*>(TreeNode::Folder::kChildrenFieldNumber) : nullptr;
+}
+
+void ResourceModelMap::IndexSubtree(MessageModel* node) {
+  R_EXPECT_V(node) << "Indexing a null tree node";
+  if (!node->GetSubModel<MessageModel*>(TreeNode::kFolderFieldNumber)) {
+    AddResource((TypeCase)node->OneOfType("type"),
+                node->Data(FieldPath::Of<TreeNode>(TreeNode::kNameFieldNumber)).toString(), node);
+    return;
+  }
+
+  // Folders are watched so that the index follows their contents as rows come and go.
+  _folderTypes.insert(node, {});
+  WatchedFolder& folder = _folders[node];
+  folder.self.append(connect(node, &ProtoModel::modelAboutToBeReset, this, [this, node]() { UnindexContents(node); }));
+  folder.self.append(connect(node, &ProtoModel::modelReset, this, [this, node]() { IndexContents(node); }));
+  IndexContents(node);
+}
 
-  // Delete all tiles using this background
-  if (type == TypeCase::kBackground) {
-    for (auto& room : qAsConst(_resources[TypeCase::kRoom])) {
-      MessageModel* roomModel = room->GetSubModel<MessageModel*>(TreeNode::kRoomFieldNumber);
-      RepeatedMessageModel* tilesModel = roomModel->GetSubModel<RepeatedMessageModel*>(Room::kTilesFieldNumber);
-      auto& remover = removers.emplace(tilesModel, tilesModel).first->second;
-
-      for (int row = 0; row < tilesModel->rowCount(); ++row) {
-        if (tilesModel
-                ->Data(
-                    FieldPath::Of<Room::Instance>(FieldPath::StartingAt(row), Room::Instance::kObjectTypeFieldNumber))
-                .toString() == name)
-          remover.RemoveRow(row);
-      }
-
-      // Only models in use in open editors should have backup models
-      MessageModel* backupModel = roomModel->GetBackupModel();
-      if (backupModel != nullptr) {
-        RepeatedMessageModel* tilesModelBak = backupModel->GetSubModel<RepeatedMessageModel*>(Room::kTilesFieldNumber);
-        auto& remover = removers.emplace(tilesModelBak, tilesModelBak).first->second;
-
-        for (int row = 0; row < tilesModelBak->rowCount(); ++row) {
-          if (tilesModelBak
-                  ->Data(FieldPath::Of<Room::Tile>(FieldPath::StartingAt(row), Room::Tile::kBackgroundNameFieldNumber))
-                  .toString() == name)
-            remover.RemoveRow(row);
-        }
-      }
+void ResourceModelMap::IndexContents(MessageModel* node) {
+  RepeatedMessageModel* children = FolderChildren(node);
+  if (!children) return;
+
+  auto indexRows = [this, children](int first, int last) {
+    for (int row = first; row <= last; ++row) IndexSubtree(children->GetSubModel(row)->TryCastAsMessageModel());
+  };
+  auto unindexRows = [this, children](int first, int last) {
+    for (int row = first; row <= last; ++row) UnindexSubtree(children->GetSubModel(row)->TryCastAsMessageModel());
+  };
+  // Moves and swaps carry each row's model along with it, so they don't affect the index.
+  WatchedFolder& folder = _folders[node];
+  folder.contents.append(connect(children, &ProtoModel::rowsInserted, this,
+                                 [indexRows](const QModelIndex&, int first, int last) { indexRows(first, last); }));
+  folder.contents.append(connect(children, &ProtoModel::rowsAboutToBeRemoved, this,
+                                 [unindexRows](const QModelIndex&, int first, int last) { unindexRows(first, last); }));
+  folder.contents.append(connect(children, &ProtoModel::RowsAboutToBeDropped, this, unindexRows));
+  folder.contents.append(connect(children, &ProtoModel::modelAboutToBeReset, this,
+                                 [unindexRows, children]() { unindexRows(0, children->rowCount() - 1); }));
+  folder.contents.append(connect(children, &ProtoModel::modelReset, this,
+                                 [indexRows, children]() { indexRows(0, children->rowCount() - 1); }));
+
+  indexRows(0, children->rowCount() - 1);
+}
+
+void ResourceModelMap::UnindexContents(MessageModel* node) {
+  auto folder = _folders.find(node);
+  if (folder == _folders.end()) return;
+  const QList<QMetaObject::Connection> contents = std::move(folder->contents);
+  folder->contents.clear();
+  for (const auto& connection : contents) disconnect(connection);
+
+  if (RepeatedMessageModel* children = FolderChildren(node)) {
+    for (int row = 0; row < children->rowCount(); ++row)
+      UnindexSubtree(children->GetSubModel(row)->TryCastAsMessageModel());
+  }
+}
+
+void ResourceModelMap::UnindexSubtree(MessageModel* node) {
+  if (!node) return;
+  if (!_folders.contains(node)) {
+    RemoveResource(node);
+    return;
+  }
+  UnindexContents(node);
+  _folderTypes.remove(node);
+  for (const auto& connection : _folders.take(node).self) disconnect(connection);
+}
+
+void ResourceModelMap::AddReference(PrimitiveModel* site) {
+  R_EXPECT_V(!_referenceSites.contains(site)) << "Reference" << site->DebugName() << "registered twice";
+  IndexedReference& ref = _referenceSites[site];
+  ref.type = site->ReferencedResourceType();
+  ref.name = site->GetAsQString();
+  ref.parent = site->GetParentModel();
+  _references[ref.type][ref.name].insert(site);
+
+  WatchedMessage& message = _referenceMessages[ref.parent];
+  if (message.sites.isEmpty()) {
+    ProtoModel* parent = ref.parent;
+    message.watcher = connect(parent, &ProtoModel::DataChanged, this,
+                              [this, parent](const QModelIndex& topLeft, const QModelIndex& bottomRight) {
+                                const QVector<PrimitiveModel*> sites = _referenceMessages.value(parent).sites;
+                                for (PrimitiveModel* site : sites) {
+                                  const int row = site->RowInParent();
+                                  if (topLeft.row() <= row && row <= bottomRight.row()) ReindexReference(site);
+                                }
+                              });
+  }
+  message.sites.append(site);
+}
+
+void ResourceModelMap::RemoveReference(PrimitiveModel* site) {
+  auto it = _referenceSites.find(site);
+  if (it == _referenceSites.end()) return;
+  auto message = _referenceMessages.find(it->parent);
+  if (message != _referenceMessages.end()) {
+    message->sites.removeOne(site);
+    if (message->sites.isEmpty()) {
+      disconnect(message->watcher);
+      _referenceMessages.erase(message);
     }
   }
+  auto type = _references.find(it->type);
+  if (type != _references.end()) {
+    auto name = type->find(it->name);
+    if (name != type->end()) {
+      name->remove(site);
+      if (name->isEmpty()) type->erase(name);
+    }
+  }
+  _referenceSites.erase(it);
+}
 
-  // NOTE: There is an unhandled BUG related to order in which references are deleted,
-  // and following hack doesnt solve it
+void ResourceModelMap::ReindexReference(PrimitiveModel* site) {
+  auto it = _referenceSites.find(site);
+  if (it == _referenceSites.end()) return;
+  QString name = site->GetAsQString();
+  if (name == it->name) return;
+  auto& sites_by_name = _references[it->type];
+  auto old = sites_by_name.find(it->name);
+  if (old != sites_by_name.end()) {
+    old->remove(site);
+    if (old->isEmpty()) sites_by_name.erase(old);
+  }
+  sites_by_name[name].insert(site);
+  it->name = std::move(name);
+}
 
-  // Remove an references to this resource
-  //emit ResourceRenamed(ResTypeAsString(type), name, "");
+bool ResourceModelMap::IsCurrentReference(PrimitiveModel* site) {
+  // An orphaned subtree keeps its internal links, so every link has to be checked, all the way up to the root.
+  const ProtoModel* model = site;
+  while (ProtoModel* parent = model->GetParentModel()) {
+    const int row = model->RowInParent();
+    if (MessageModel* message = parent->TryCastAsMessageModel()) {
+      if (message->SubModelForRow(row) != model) return false;
+    } else if (RepeatedModel* repeated = parent->TryCastAsRepeatedModel()) {
+      if (row < 0 || row >= repeated->rowCount() || repeated->GetSubModel(row) != model) return false;
+    } else {
+      return false;
+    }
+    model = parent;
+  }
+  return !model->IsRetired();
+}
 
-  // Remove references to this resource
-  _resources[type].remove(name);
-  emit DataChanged();
+QList<PrimitiveModel*> ResourceModelMap::References(const QString& type, const QString& name) {
+  QList<PrimitiveModel*> sites;
+  auto by_type = _references.find(type);
+  if (by_type == _references.end()) return sites;
+  auto by_name = by_type->find(name);
+  if (by_name == by_type->end()) return sites;
+
+  QList<PrimitiveModel*> stale;
+  for (PrimitiveModel* site : qAsConst(*by_name)) {
+    if (IsCurrentReference(site)) sites.append(site);
+    else stale.append(site);
+  }
+  for (PrimitiveModel* site : qAsConst(stale)) RemoveReference(site);
+  return sites;
 }
 
-QString ResourceModelMap::CreateResourceName(TreeNode* node) {
+// Room contents which only exist to place a resource, and so go away with it.
+static bool IsOwningReference(const FieldDescriptor* field) {
+  return field == Room::Instance::descriptor()->FindFieldByNumber(Room::Instance::kObjectTypeFieldNumber) ||
+         field == Room::Tile::descriptor()->FindFieldByNumber(Room::Tile::kBackgroundNameFieldNumber);
+}
+
+void ResourceModelMap::ResourcesRemoved(const QVector<QPair<TypeCase, QString>>& resources,
+                                        std::map<ProtoModel*, RepeatedMessageModel::RowRemovalOperation>& removers) {
+  bool removed = false;
+  for (const auto& resource : resources) {
+    const TypeCase type = resource.first;
+    const QString& name = resource.second;
+    if (type == TypeCase::kFolder) continue;
+    MessageModel* model = _resources.value(type).value(name);
+    if (!model) continue;
+
+    // Delete all instances of this object and all tiles using this background, in the project and in editor backups.
+    for (PrimitiveModel* site : References(QString::fromStdString(ResTypeAsString(type)), name)) {
+      if (!IsOwningReference(site->GetFieldDescriptor())) continue;
+      MessageModel* element = site->GetParentModel<MessageModel>();
+      RepeatedMessageModel* list = element->GetParentModel<RepeatedMessageModel>();
+      R_ASSESS_C(list);
+      removers.emplace(list, list).first->second.RemoveRow(element->RowInParent());
+    }
+
+    // NOTE: There is an unhandled BUG related to order in which references are deleted,
+    // and following hack doesnt solve it
+
+    // Remove an references to this resource
+    //emit ResourceRenamed(ResTypeAsString(type), name, "");
+
+    // Remove references to this resource
+    RemoveResource(model);
+    removed = true;
+  }
+  if (removed) emit DataChanged();
+}
+
+static QString DefaultNamePrefix(const TreeNode* node) {
   auto fieldNum = ResTypeFields[node->type_case()];
   const Descriptor* desc = node->GetDescriptor();
   const FieldDescriptor* field = desc->FindFieldByNumber(fieldNum);
-  const QString fieldName = node->has_folder() ? "group" : QString::fromStdString(field->name());
-  return CreateResourceName(node->type_case(), fieldName);
+  return node->has_folder() ? "group" : QString::fromStdString(field->name());
+}
+
+// The length of the name without its trailing number, if any.
+static int NumberedPrefixLength(const QString& name) {
+  int length = name.size();
+  while (length > 0 && name[length - 1].isDigit()) --length;
+  return length;
+}
+
+QString ResourceModelMap::CreateResourceName(TreeNode* node) {
+  return CreateResourceName(node->type_case(), DefaultNamePrefix(node));
 }
 
 QString ResourceModelMap::CreateResourceName(int type, const QString& typeName) {
-  const QString pre = typeName;
-  QString name;
-  int i = 0;
-  do {
-    name = pre + QString::number(i++);
-  } while (_resources[type].contains(name));
-  return name;
+  return CreateResourceNames(type, typeName, 1).front();
+}
+
+QStringList ResourceModelMap::CreateResourceNames(int type, const QString& typeName, int count) {
+  QStringList names;
+  names.reserve(count);
+  const auto& taken = _resources[type];
+  NameCounter& counter = _nameCounters[type][typeName];
+
+  // Numbers freed up since the counter passed them come first, lowest first. Any that were taken again are dropped.
+  for (auto gap = counter.gaps.begin(); gap != counter.gaps.end() && names.size() < count;) {
+    QString name = typeName + QString::number(*gap);
+    if (taken.contains(name)) {
+      gap = counter.gaps.erase(gap);
+      continue;
+    }
+    names.append(std::move(name));
+    ++gap;
+  }
+
+  // Names handed out earlier may have been added since; the counter skips over them once and never looks back.
+  for (int i = counter.next; names.size() < count; ++i) {
+    QString name = typeName + QString::number(i);
+    if (taken.contains(name)) {
+      if (i == counter.next) ++counter.next;
+      continue;
+    }
+    names.append(std::move(name));
+  }
+  return names;
+}
+
+void ResourceModelMap::AssignUniqueNames(TreeNode* root) {
+  // Collect every node in the subtree by the name it would be numbered after, then name each group in one go.
+  QHash<QPair<int, QString>, QVector<TreeNode*>> groups;
+  QVector<QPair<int, QString>> order;
+  std::function<void(TreeNode*)> collect = [&](TreeNode* node) {
+    QString prefix = QString::fromStdString(node->name());
+    prefix.truncate(NumberedPrefixLength(prefix));
+    if (prefix.isEmpty()) prefix = DefaultNamePrefix(node);
+    const QPair<int, QString> key(node->type_case(), prefix);
+    auto group = groups.find(key);
+    if (group == groups.end()) {
+      group = groups.insert(key, {});
+      order.append(key);
+    }
+    group->append(node);
+    if (node->has_folder()) {
+      for (TreeNode& child : *node->mutable_folder()->mutable_children()) collect(&child);
+    }
+  };
+  collect(root);
+
+  for (const auto& key : qAsConst(order)) {
+    const QVector<TreeNode*>& nodes = groups[key];
+    const QStringList names = CreateResourceNames(key.first, key.second, nodes.size());
+    for (int i = 0; i < nodes.size(); ++i) nodes[i]->set_name(names[i].toStdString());
+  }
+}
+
+void ResourceModelMap::ReleaseName(int type, const QString& name) {
+  auto counters = _nameCounters.find(type);
+  if (counters == _nameCounters.end()) return;
+  const int digits = NumberedPrefixLength(name);
+  auto counter = counters->find(name.left(digits));
+  if (counter == counters->end()) return;
+  bool ok = false;
+  const QStringRef suffix = name.midRef(digits);
+  const int number = suffix.toInt(&ok);
+  // Only names CreateResourceNames could have produced count, so "sprite07" doesn't free up "sprite7".
+  if (ok && number < counter->next && suffix == QString::number(number)) counter->gaps.insert(number);
 }
 
 bool ResourceModelMap::ValidName(TypeCase type, const QString& name) {
@@ -204,10 +460,24 @@ TypeCase Type(TreeModel::Node* node) {
 
 void ResourceModelMap::ResourceRenamed(TypeCase type, const QString& oldName, const QString& newName) {
   if (oldName == newName || !_resources[type].contains(oldName)) return;
-  _resources[type][newName] = _resources[type][oldName];
+  MessageModel* model = _resources[type][oldName];
+  _resources[type][newName] = model;
+  _resourceKeys[model].name = newName;
+  BindId(type, newName, model);
+  BindId(type, oldName, nullptr);
+  ReleaseName(type, oldName);
+
+  // Point every field that referred to the old name at the new one.
+  const std::string typeName = ResTypeAsString(type);
+  for (PrimitiveModel* site : References(QString::fromStdString(typeName), oldName)) {
+    site->ExtensionChanged<decltype(buffers::resource_ref)>(buffers::resource_ref, typeName, oldName, newName);
+    // ExtensionChanged blocks signals, so the index has to be told about the change directly.
+    ReindexReference(site);
+  }
 
-  emit ResourceRenamed(ResTypeAsString(type), oldName, newName);
+  emit ResourceRenamed(typeName, oldName, newName);
   _resources[type].remove(oldName);
+  emit ResourceNameChanged(model);
 
   emit DataChanged();
 }
@@ -217,7 +487,10 @@ MessageModel* GetObjectSprite(const std::string& object_name) {
 }
 
 MessageModel* GetObjectSprite(const QString& object_name) {
-  MessageModel* obj = MainWindow::resourceMap->GetResourceByName(TreeNode::kObject, object_name);
+  return GetObjectSprite(MainWindow::resourceMap->GetResourceByName(TreeNode::kObject, object_name));
+}
+
+MessageModel* GetObjectSprite(MessageModel* obj) {
   if (!obj) return nullptr;
   obj = obj->GetSubModel<MessageModel*>(TreeNode::kObjectFieldNumber);
   if (!obj) return nullptr;
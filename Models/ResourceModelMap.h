@@ -6,37 +6,145 @@
 
 #include <QHash>
 #include <QIcon>
+#include <QSet>
+#include <QStringList>
 #include <QVector>
+#include <set>
 #include <string>
 
+class ObjectSpriteCache;
+
 class ResourceModelMap : public QObject {
   Q_OBJECT
  public:
   ResourceModelMap(QObject* parent);
   MessageModel* GetResourceByName(int type, const QString& name);
   MessageModel* GetResourceByName(int type, const std::string& name);
+
+  // Resource names are interned into small integer ids, so code that resolves the same names over and over (painting a
+  // room, sorting its instances) can cache the ids and look resources up in a flat vector instead of hashing strings.
+  // An id stays valid for the lifetime of the map; while no resource goes by its name, it resolves to nullptr.
+  using ResourceId = int;
+  static constexpr ResourceId kNoResource = -1;
+  ResourceId InternName(int type, const QString& name);
+  MessageModel* GetResourceById(ResourceId id) const {
+    return id >= 0 && id < _resourcesById.size() ? _resourcesById[id] : nullptr;
+  }
+  // How each object is drawn in rooms, keyed by object id.
+  ObjectSpriteCache* ObjectSprites() const { return _objectSprites; }
+
+  // Registers a resource by hand. Resources inserted into the tree are picked up on their own; see TreeChanged.
   void AddResource(TypeCase type, const QString& name, MessageModel* model);
   QString CreateResourceName(TreeNode* node);
   QString CreateResourceName(int type, const QString& typeName);
+  // Returns `count` distinct names of the form typeName + number that are all free right now. Prefer this to calling
+  // CreateResourceName in a loop, which would hand out the same name until the caller adds it.
+  QStringList CreateResourceNames(int type, const QString& typeName, int count);
+  // Renames every resource in the given subtree (which isn't in the project yet) to a free name. Each keeps its name
+  // minus any trailing number as a prefix, e.g. for a duplicated subtree.
+  void AssignUniqueNames(TreeNode* root);
   bool ValidName(TypeCase type, const QString& name);
+  // Every resource in the index, in no particular order.
+  QList<MessageModel*> IndexedResources() const { return _resourceKeys.keys(); }
+  // Looks up the type and name a resource is indexed under. Returns false if it isn't indexed.
+  bool ResourceKeyOf(MessageModel* node, int* type, QString* name) const;
+  // Whether the given tree node is a resource of the given type, or a folder with one somewhere inside it. This is
+  // constant time: each folder counts the resources of every type below it as they are indexed and unindexed.
+  bool ContainsType(const ProtoModel* node, int type) const;
+
+  // Reverse references. Every resource_ref field (including those in editor backups) registers itself here under the
+  // name it currently holds, so renames and deletions only visit the fields that actually refer to the resource.
+  void AddReference(PrimitiveModel* site);
+  void RemoveReference(PrimitiveModel* site);
+  // Returns the fields of the given resource type (as spelled in resource_ref) which currently hold the given name.
+  QList<PrimitiveModel*> References(const QString& type, const QString& name);
 
  public slots:
   void dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles = QVector<int>());
+  // Rebuilds the name index from scratch for the tree rooted at the given node. This only has to happen once per
+  // project; from then on, the index follows row insertions, removals and resets of every folder in the tree.
   void TreeChanged(MessageModel* model);
   void ResourceRenamed(TypeCase type, const QString& oldName, const QString& newName);
-  void ResourceRemoved(TypeCase type, const QString& name,
-                      std::map<ProtoModel*, RepeatedModel::RowRemovalOperation>& removers);
+  // Drops the given resources from the index and queues the removal of everything they own (room instances, tiles).
+  void ResourcesRemoved(const QVector<QPair<TypeCase, QString>>& resources,
+                        std::map<ProtoModel*, RepeatedModel::RowRemovalOperation>& removers);
 
  signals:
   void DataChanged();
+  // A resource in the tree was added to, or is about to be dropped from, the name index. Its model is still intact.
+  void ResourceIndexed(MessageModel* node);
+  void ResourceUnindexed(MessageModel* node);
+  // An indexed resource was renamed; ResourceKeyOf already gives its new name.
+  void ResourceNameChanged(MessageModel* node);
+  // Some folder gained its first, or lost its last, resource of the given type.
+  void TypePresenceChanged(int type);
   void ResourceRenamed(const std::string& type, const QString& oldName, const QString& newName);
 
  protected:
   QHash<int, QHash<QString, MessageModel*>> _resources;
+
+ private:
+  struct ResourceKey {
+    int type;
+    QString name;
+  };
+  struct WatchedFolder {
+    QList<QMetaObject::Connection> self;      // Resets of the folder node itself.
+    QList<QMetaObject::Connection> contents;  // Row changes in its list of children.
+  };
+  void RemoveResource(MessageModel* model);
+  // Adds delta to the count of the given type in every folder above the given node.
+  void CountType(const ProtoModel* node, int type, int delta);
+  void BindId(int type, const QString& name, MessageModel* model);
+  // Lets CreateResourceNames reuse the number of a name that is no longer in use.
+  void ReleaseName(int type, const QString& name);
+  // Adds the resources in the given subtree to the index and starts following changes to its folders.
+  void IndexSubtree(MessageModel* node);
+  void IndexContents(MessageModel* folder);
+  // Reverses IndexSubtree. Must be called while the subtree's models are still intact.
+  void UnindexSubtree(MessageModel* node);
+  void UnindexContents(MessageModel* folder);
+
+  QHash<MessageModel*, ResourceKey> _resourceKeys;
+  QHash<MessageModel*, WatchedFolder> _folders;
+  QHash<const ProtoModel*, QVector<int>> _folderTypes;  // For each folder, the resources below it, by type.
+  QHash<int, QHash<QString, ResourceId>> _nameIds;
+  QVector<MessageModel*> _resourcesById;
+
+  // For each type and name prefix, every number below `next` was found taken at some point. The ones in `gaps` have
+  // been freed since. Candidates are always checked against the index again before they're handed out.
+  struct NameCounter {
+    int next = 0;
+    std::set<int> gaps;
+  };
+  QHash<int, QHash<QString, NameCounter>> _nameCounters;
+  ObjectSpriteCache* _objectSprites;
+
+  struct IndexedReference {
+    QString type, name;
+    ProtoModel* parent;  // The message holding the field, as of registration.
+  };
+  // Singular fields don't emit anything themselves; their containing message announces changes to them. Each such
+  // message is subscribed to once, however many reference fields it has.
+  struct WatchedMessage {
+    QMetaObject::Connection watcher;
+    QVector<PrimitiveModel*> sites;
+  };
+  // Moves the site to wherever its current value says it belongs.
+  void ReindexReference(PrimitiveModel* site);
+  // True if the site, and every model above it, still backs its row in its parent; that is, it hasn't been orphaned by
+  // some ancestor rebuilding its submodels.
+  static bool IsCurrentReference(PrimitiveModel* site);
+
+  QHash<QString, QHash<QString, QSet<PrimitiveModel*>>> _references;  // type -> name -> sites
+  QHash<PrimitiveModel*, IndexedReference> _referenceSites;
+  QHash<ProtoModel*, WatchedMessage> _referenceMessages;
 };
 
 MessageModel* GetObjectSprite(const std::string& object_name);
 MessageModel* GetObjectSprite(const QString& object_name);
+/// Takes the object's tree node, e.g. as returned by GetResourceById.
+MessageModel* GetObjectSprite(MessageModel* object_node);
 
 QIcon GetSpriteIconByName(const QString& sprite_name);
 /// Wraps GetSpriteIconByName, but expects the QVariant field content rather than a direct string.
@@ -5,44 +5,88 @@
 #include "Components/Logger.h"
 #include "Models/ResourceModelMap.h"
 
+#include <QCollator>
 #include <QCoreApplication>
 #include <QItemSelectionModel>
 #include <QMimeData>
-#include <QStack>
-
-static QSet<const QModelIndex> GroupNodes(const QSet<const QModelIndex> &nodes) {
-  QSet <const QModelIndex> ret;
-  for (const auto& n : nodes) {
-    QModelIndex t = n;
-    bool add = true;
-    while (t.parent().isValid()) {
-      if (nodes.contains(t.parent())) {
-        add = false;
-        break;
-      }
-      t = t.parent();
+#include <QThread>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+// Drag and drop payload: a header naming the tree that wrote it, then the path of rows from the root to each dragged
+// node, all as varints.
+static const char kTreePathsMimeType[] = "application/x-radialgm-tree-paths";
+static const char kTreePathsMagic[] = "RGMT";
+static constexpr quint32 kTreePathsVersion = 1;
+
+static quint64 NextDragToken() {
+  static quint64 next = 0;
+  return ++next;
+}
+
+namespace {
+
+// Also offers the dragged nodes as a single TreeNode (a folder holding copies of them), for pasting into another
+// project. The copy is only serialized if someone asks for it.
+class TreeMimeData : public QMimeData {
+ public:
+  TreeMimeData(const TreeModel *model, const QModelIndexList &indexes) : model_(model) {
+    for (const QModelIndex &index : indexes) nodes_.append(index);
+  }
+
+  QStringList formats() const override {
+    QStringList formats = QMimeData::formats();
+    formats.append(MessageMimeType(TreeNode::descriptor()));
+    return formats;
+  }
+
+ protected:
+  QVariant retrieveData(const QString &mimeType, QVariant::Type type) const override {
+    if (mimeType != MessageMimeType(TreeNode::descriptor())) return QMimeData::retrieveData(mimeType, type);
+    TreeNode bundle;
+    auto *children = bundle.mutable_folder()->mutable_children();
+    for (const QPersistentModelIndex &index : nodes_) {
+      // The tree may have changed, or even been closed, since the drag started.
+      if (!index.isValid() || index.model() != model_) continue;
+      if (TreeModel::Node *node = model_->IndexToNode(index)) *children->Add() = node->GetMessage();
     }
-    if (add) ret.insert(n);
+    return QByteArray::fromStdString(bundle.SerializeAsString());
   }
-  return ret;
-}
+
+ private:
+  const TreeModel *model_;
+  QList<QPersistentModelIndex> nodes_;
+};
+
+}  // namespace
 
 TreeModel::TreeModel(MessageModel *root, QObject *parent, const DisplayConfig &config)
     : QAbstractItemModel(parent),
       mime_types_(GetMimeTypes(root->GetDescriptor())),
       display_config_(config),
       root_(std::make_shared<Node>(this, nullptr, -1, root, -1)),
-      root_model_(root) {
+      root_model_(root),
+      drag_token_(NextDragToken()) {
+  mime_types_.prepend(kTreePathsMimeType);
+  connect(ArtManager::Loader(), &ArtLoader::IconLoaded, this, &TreeModel::IconLoaded);
+  // The root is never collapsed, so views will not ask for its children.
+  root_->Populate();
   RebuildModelMapping();
   connect(root, &MessageModel::modelReset, this, &TreeModel::DataBlownAway);
 }
 
 void TreeModel::DataBlownAway() {
   emit TreeChanged(root_model_);
-  beginResetModel();
-  root_->RebuildFromModel(root_model_, nullptr, 0);
-  RebuildModelMapping();
-  endResetModel();
+  // Every submodel was replaced, but most of the tree usually survives. Diffing the new tree against the old one
+  // keeps folders expanded and items selected.
+  root_->RowsChanged();
 }
 
 void TreeModel::RebuildModelMapping() {
@@ -68,6 +112,14 @@ void TreeModel::Node::AddSelfToMap(const std::shared_ptr<Node> &self) {
   for (const auto &child : children) child->AddSelfToMap(child);
 }
 
+void TreeModel::Node::RemoveSelfFromMap() {
+  auto &map = backing_tree->backing_nodes_;
+  auto it = map.find(passthrough_model ? passthrough_model : backing_model);
+  if (it != map.end() && it->get() == this) map.erase(it);
+  if (passthrough_node) passthrough_node->RemoveSelfFromMap();
+  for (const auto &child : children) child->RemoveSelfFromMap();
+}
+
 // =====================================================================================================================
 // == Tree Querying ====================================================================================================
 // =====================================================================================================================
@@ -81,6 +133,42 @@ int TreeModel::rowCount(const QModelIndex &parent) const {
   return node->children.size();
 }
 
+bool TreeModel::hasChildren(const QModelIndex &parent) const {
+  if (parent.column() > 0) return false;
+  Node *node = IndexToNode(parent);
+  R_EXPECT(node, false) << "Checking children of bad Node.";
+  return !node->children.empty() || node->CanFetchMore();
+}
+
+bool TreeModel::canFetchMore(const QModelIndex &parent) const {
+  if (parent.column() > 0) return false;
+  Node *node = IndexToNode(parent);
+  return node && node->CanFetchMore();
+}
+
+void TreeModel::fetchMore(const QModelIndex &parent) {
+  Node *node = IndexToNode(parent);
+  if (!node || !node->CanFetchMore()) return;
+  beginInsertRows(parent, 0, node->BackingModel()->rowCount() - 1);
+  node->Populate();
+  endInsertRows();
+}
+
+void TreeModel::fetchAll(const QModelIndex &parent) {
+  if (canFetchMore(parent)) fetchMore(parent);
+  for (int row = 0; row < rowCount(parent); ++row) fetchAll(index(row, 0, parent));
+}
+
+void TreeModel::releaseChildren(const QModelIndex &index) {
+  if (!index.isValid()) return;
+  Node *node = IndexToNode(index);
+  // Only repeated message nodes know how to build their children again.
+  if (!node || node->children.empty() || !node->BackingModel()->TryCastAsRepeatedMessageModel()) return;
+  beginRemoveRows(index, 0, node->children.size() - 1);
+  node->Release();
+  endRemoveRows();
+}
+
 bool TreeModel::setData(const QModelIndex &index, const QVariant &value, int role) {
   if (!index.isValid() || role != Qt::EditRole) return false;
   Node *node = IndexToNode(index);
@@ -106,7 +194,7 @@ QVariant TreeModel::data(const QModelIndex &index, int role) const {
   switch (role) {
     case Qt::EditRole:
     case Qt::DisplayRole: return IndexToNode(index)->display_name;
-    case Qt::DecorationRole: return IndexToNode(index)->display_icon;
+    case Qt::DecorationRole: return IndexToNode(index)->DisplayIcon();
   }
   return {};
 }
@@ -125,91 +213,121 @@ Qt::DropActions TreeModel::supportedDropActions() const { return Qt::MoveAction
 QStringList TreeModel::mimeTypes() const { return mime_types_; }
 
 QMimeData *TreeModel::mimeData(const QModelIndexList &indexes) const {
-  QModelIndexList sortedIndexes = indexes;
-  // Serialize the indexes in ascending order so we can make assumptions
-  std::sort(sortedIndexes.begin(), sortedIndexes.end(),
-            [](QModelIndex &a, QModelIndex &b) { return a.row() < b.row(); });
-
-  QMimeData *mimeData = new QMimeData();
-  QByteArray encodedData;
-  QDataStream stream(&encodedData, QIODevice::WriteOnly);
-
-  foreach (const QModelIndex &index, sortedIndexes) {
+  // Each node is written as its path of rows from the root. Sorting the paths puts them in tree order.
+  std::vector<std::vector<int>> paths;
+  paths.reserve(indexes.size());
+  for (const QModelIndex &index : indexes) {
     if (!index.isValid()) continue;
-
-    // Build the path bottom-up to put it into normal form
-    QStack<int> path;
-    path.push(index.row());
-    QModelIndex parent = index.parent();
-    while (parent.isValid()) {
-      path.push(parent.row());
-      parent = parent.parent();
-    }
-
-    // Serialize the path on the stack
-    stream << path.pop();
-    while (!path.isEmpty()) {
-      stream << QString("/") << path.pop();
+    const Node *node = IndexToNode(index);
+    if (node) paths.push_back(node->PathFromRoot());
+  }
+  std::sort(paths.begin(), paths.end());
+  paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+
+  std::string encoded;
+  {
+    google::protobuf::io::StringOutputStream raw(&encoded);
+    google::protobuf::io::CodedOutputStream out(&raw);
+    out.WriteRaw(kTreePathsMagic, sizeof(kTreePathsMagic) - 1);
+    out.WriteVarint32(kTreePathsVersion);
+    out.WriteVarint64(QCoreApplication::applicationPid());
+    out.WriteVarint64(drag_token_);
+    out.WriteVarint32(paths.size());
+    for (const auto &path : paths) {
+      out.WriteVarint32(path.size());
+      for (int row : path) out.WriteVarint32(row);
     }
-    stream << QString(";");
   }
 
-  mimeData->setData(mimeTypes()[0], encodedData);
+  QMimeData *mimeData = new TreeMimeData(this, indexes);
+  mimeData->setData(kTreePathsMimeType, QByteArray::fromStdString(encoded));
   return mimeData;
 }
 
-bool TreeModel::dropMimeData(const QMimeData *mimeData, Qt::DropAction action, int row, int column,
+TreeModel::DecodedPaths TreeModel::DecodeTreePaths(const QMimeData *mimeData, QModelIndexList *indexes) const {
+  if (!mimeData->hasFormat(kTreePathsMimeType)) return DecodedPaths::kForeign;
+  const QByteArray data = mimeData->data(kTreePathsMimeType);
+  google::protobuf::io::CodedInputStream in(reinterpret_cast<const uint8_t *>(data.constData()), data.size());
+
+  std::string magic;
+  quint32 version = 0, count = 0;
+  quint64 pid = 0, token = 0;
+  if (!in.ReadString(&magic, sizeof(kTreePathsMagic) - 1) || magic != kTreePathsMagic) return DecodedPaths::kForeign;
+  if (!in.ReadVarint32(&version) || version != kTreePathsVersion) return DecodedPaths::kForeign;
+  if (!in.ReadVarint64(&pid) || !in.ReadVarint64(&token) || !in.ReadVarint32(&count)) return DecodedPaths::kForeign;
+  // Paths are only meaningful to the tree that wrote them.
+  if (pid != quint64(QCoreApplication::applicationPid()) || token != drag_token_) return DecodedPaths::kForeign;
+
+  QModelIndexList resolved;
+  for (quint32 i = 0; i < count; ++i) {
+    quint32 depth = 0, row = 0;
+    R_EXPECT(in.ReadVarint32(&depth), DecodedPaths::kStale) << "Truncated tree path in drop data";
+    Node *node = root_.get();
+    for (quint32 step = 0; step < depth; ++step) {
+      R_EXPECT(in.ReadVarint32(&row), DecodedPaths::kStale) << "Truncated tree path in drop data";
+      node = node->NthChild(row);
+      R_EXPECT(node, DecodedPaths::kStale) << "Dropped tree path no longer exists";
+    }
+    if (node != root_.get()) resolved.append(node->IndexInTree());
+  }
+  *indexes += resolved;
+  return DecodedPaths::kResolved;
+}
+
+bool TreeModel::dropMimeData(const QMimeData *mimeData, Qt::DropAction action, int row, int /*column*/,
                              const QModelIndex &parent) {
   if (action != Qt::MoveAction && action != Qt::CopyAction) return false;
-  // ensure the data is in the format we expect
-  if (!mimeData->hasFormat(mimeTypes()[0])) return false;
-  QByteArray data = mimeData->data(mimeTypes()[0]);
-  QDataStream stream(&data, QIODevice::ReadOnly);
 
   Node *parentNode = IndexToNode(parent);
   if (!parentNode) parentNode = root_.get();
+  if (canFetchMore(parent)) fetchMore(parent);
   if (row == -1) row = rowCount(parent);
-  QSet<const QModelIndex> nodes;
-  std::vector<Message*> messages;
-
-  while (!stream.atEnd()) {
-    int itemRow = 0;
-    stream >> itemRow;
-    QModelIndex index = this->index(itemRow, 0, QModelIndex());
-    QString delimiter = "";
-    stream >> delimiter;
-    while (delimiter != ";") {
-      stream >> itemRow;
-      index = this->index(itemRow, 0, index);
-      stream >> delimiter;
+
+  QModelIndexList dropped;
+  const DecodedPaths decoded = DecodeTreePaths(mimeData, &dropped);
+  // The nodes were dragged from this tree, which has changed since. Copying them from the serialized messages instead
+  // would leave the originals of a move in place.
+  if (decoded == DecodedPaths::kStale) return false;
+  if (decoded == DecodedPaths::kForeign) {
+    // Nodes from another tree can only be copied, from their serialized messages.
+    const QString nodesMimeType = MessageMimeType(TreeNode::descriptor());
+    if (!mimeData->hasFormat(nodesMimeType)) return false;
+    const QByteArray data = mimeData->data(nodesMimeType);
+    TreeNode bundle;
+    R_EXPECT(bundle.ParseFromArray(data.constData(), data.size()), false) << "Dropped tree nodes are corrupt";
+    for (TreeNode &node : *bundle.mutable_folder()->mutable_children()) {
+      MainWindow::resourceMap->AssignUniqueNames(&node);
+      parentNode->insert(node, row++);
     }
-    nodes.insert(index);
+    return true;
   }
-  nodes = GroupNodes(nodes);
-
-  for (auto index : nodes) {
-    auto node = IndexToNode(index);
-    auto oldParent = index.parent();
-
-    auto msg = node->GetMessage();
-    Message* m_copy = msg.New();
-    m_copy->CopyFrom(msg);
-    messages.push_back(m_copy);
 
-    if (action == Qt::MoveAction) {
-      // offset the row to insert at by the number of
-      // rows already removed from the same parent
-      if (parent == oldParent && index.row() < row)
-        --row;
+  // Don't separately drop children of dropped groups.
+  QSet<const QModelIndex> nodes;
+  for (const QModelIndex &index : qAsConst(dropped)) nodes.insert(index);
+  QModelIndexList grouped;
+  for (Node *node : OutermostNodes(nodes)) grouped.append(node->IndexInTree());
+
+  if (action == Qt::MoveAction) {
+    // Moving a group into itself would orphan it.
+    for (QModelIndex ancestor = parent; ancestor.isValid(); ancestor = ancestor.parent()) {
+      if (nodes.contains(ancestor)) return false;
     }
+    if (MoveNodes(grouped, parentNode, row)) return true;
   }
 
-  if (action == Qt::MoveAction)
-    BatchRemove(nodes);
+  std::vector<TreeNode> messages;
+  for (const QModelIndex &index : qAsConst(grouped)) {
+    messages.push_back(IndexToNode(index)->GetMessage());
+    // Rows removed from before the drop point shift it up.
+    if (action == Qt::MoveAction && index.parent() == parent && index.row() < row) --row;
+  }
 
-  for (auto* msg : messages) {
-    parentNode->insert(*msg, row);
-    delete msg;
+  if (action == Qt::MoveAction) BatchRemove(nodes);
+
+  for (TreeNode &message : messages) {
+    if (action == Qt::CopyAction) MainWindow::resourceMap->AssignUniqueNames(&message);
+    parentNode->insert(message, row++);
   }
 
   return true;
@@ -248,7 +366,7 @@ TreeModel::Node *TreeModel::IndexToNode(const QModelIndex &index) const {
     R_EXPECT(IsValidNode(parent), nullptr) << "Dangling internal pointer to tree Node: " << parent;
     Node *node = parent->NthChild(index.row());
     if (!node) return nullptr;
-    R_EXPECT(root_model_->ValidateSubModel(node->BackingModel()), nullptr)
+    R_EXPECT(reconciling_ || root_model_->ValidateSubModel(node->BackingModel()), nullptr)
         << "Tree contains a node (" << node->DebugPath() << ") with a dead model attached.";
     return node;
   } else {
@@ -256,46 +374,73 @@ TreeModel::Node *TreeModel::IndexToNode(const QModelIndex &index) const {
   }
 }
 
-static void CollectNodes(const QModelIndex &node, QSet<const QModelIndex> &cache) {
-  auto model = node.model();
+bool TreeModel::MoveNodes(const QModelIndexList &indexes, Node *parent_node, int row) {
+  auto *const destination = parent_node->BackingModel()->TryCastAsRepeatedMessageModel();
+  if (!destination) return false;
+  // Resolve everything to models first. The models survive the moves; the indexes do not.
+  std::vector<MessageModel *> models;
+  for (const QModelIndex &index : indexes) {
+    Node *node = IndexToNode(index);
+    R_EXPECT(node, false) << "Dropped index " << index << " has no tree node.";
+    MessageModel *model = node->SourceModel()->TryCastAsMessageModel();
+    auto *const source = model ? model->GetParentModel<RepeatedMessageModel>() : nullptr;
+    if (!source || !source->CanMoveRowsTo(destination)) return false;
+    models.push_back(model);
+  }
 
-  cache.insert(node);
-  for (int r = 0; r < model->rowCount(node); ++r) {
-    CollectNodes(model->index(r, 0, node), cache);
+  // Every move shifts rows and reindexes what it touched, so nodes which sit next to each other in one field and were
+  // dragged in that order are moved together.
+  for (size_t first = 0; first < models.size();) {
+    auto *const source = models[first]->GetParentModel<RepeatedMessageModel>();
+    const int source_row = models[first]->RowInParent();
+    size_t end = first + 1;
+    while (end < models.size() && models[end]->GetParentModel<RepeatedMessageModel>() == source &&
+           models[end]->RowInParent() == source_row + int(end - first)) {
+      ++end;
+    }
+    const int count = int(end - first);
+    // Within one field, dropping rows right before, after or among themselves leaves them where they are.
+    if (source != destination || row < source_row || row > source_row + count)
+      source->MoveRowsTo(source_row, count, destination, row);
+    row = models[end - 1]->RowInParent() + 1;
+    first = end;
   }
+  return true;
+}
+
+std::vector<TreeModel::Node *> TreeModel::OutermostNodes(const QSet<const QModelIndex> &indexes) const {
+  // In tree order, everything inside a node comes right after it, so one pass can skip whatever the last kept node
+  // already covers.
+  std::vector<std::pair<std::vector<int>, Node *>> ordered;
+  ordered.reserve(indexes.size());
+  for (const QModelIndex &index : indexes) {
+    if (!index.isValid()) continue;
+    Node *node = IndexToNode(index);
+    R_ASSESS_C(node);
+    ordered.emplace_back(node->PathFromRoot(), node);
+  }
+  std::sort(ordered.begin(), ordered.end(),
+            [](const auto &a, const auto &b) { return a.first < b.first; });
+
+  std::vector<Node *> nodes;
+  const std::vector<int> *outer = nullptr;
+  for (const auto &[path, node] : ordered) {
+    if (outer && path.size() >= outer->size() && std::equal(outer->begin(), outer->end(), path.begin())) continue;
+    nodes.push_back(node);
+    outer = &path;
+  }
+  return nodes;
 }
 
 void TreeModel::BatchRemove(const QSet<const QModelIndex> &indexes) {
   std::map<ProtoModel*, RepeatedMessageModel::RowRemovalOperation> removers;
   QVector<QPair<TreeNode::TypeCase, QString>> deletedResources;
 
-  // Fully expand groups so we can correctly fire all necessary ItemRemoved signals
-  QSet<const QModelIndex> selectedNodes;
-  for (auto& index : qAsConst(indexes)) {
-    CollectNodes(index, selectedNodes);
-  }
-
-  // Loop all selected
-  for (auto& index : qAsConst(selectedNodes)) {
-    Node* node = IndexToNode(index);
-    R_ASSESS_C(node && node->BackingModel());
-    MessageModel* m = node->BackingModel()->TryCastAsMessageModel();
-    if (m) {
-      emit ModelAboutToBeDeleted(m);
-      MessageModel* parent = m->GetParentModel<MessageModel*>();
-      R_ASSESS_C(parent);
-      TreeNode::TypeCase type = (buffers::TreeNode::TypeCase)parent->OneOfType("type");
-      deletedResources.append({type, index.data().toString()});
-    }
-  }
-
   // Don't delete children of deleted indexes
-  QSet<const QModelIndex> nodes = GroupNodes(indexes);
-
-  for (auto& index : qAsConst(nodes)) {
-    Node* node = IndexToNode(index);
-    R_ASSESS_C(node && node->BackingModel());
+  const std::vector<Node *> nodes = OutermostNodes(indexes);
 
+  std::vector<MessageModel *> pending;
+  for (Node *node : nodes) {
     ProtoModel *remove_me = node->BackingModel();
     RepeatedMessageModel *remove_from = nullptr;
 
@@ -305,19 +450,45 @@ void TreeModel::BatchRemove(const QSet<const QModelIndex> &indexes) {
     }
 
     R_ASSESS_C(remove_from);
-    //TODO: Calling redundantly so delete/dnd last child of group doesn't spam warnings
-    //RowRemovalOperation resets model which for some reason doesn't fix it, but this does
-    //Calling begin/end remove fixes both cases
-    beginRemoveRows(index.parent(), index.row(), index.row());
     removers.emplace(remove_from, remove_from).first->second.RemoveRow(remove_me->RowInParent());
-    endRemoveRows();
+    if (MessageModel *tree_node = remove_me->TryCastAsMessageModel()) pending.push_back(tree_node);
+  }
+
+  // Report every resource inside the removed groups. The protos are walked directly so that groups nobody
+  // expanded don't have to be built into the tree just to be thrown away.
+  while (!pending.empty()) {
+    MessageModel *tree_node = pending.back();
+    pending.pop_back();
+    if (const auto *folder = tree_node->GetSubModel<MessageModel*>(TreeNode::kFolderFieldNumber)) {
+      if (auto *children = folder->GetSubModel<RepeatedMessageModel*>(TreeNode::Folder::kChildrenFieldNumber)) {
+        for (int row = 0; row < children->rowCount(); ++row)
+          if (MessageModel *child = children->GetSubModel(row)->TryCastAsMessageModel()) pending.push_back(child);
+      }
+      continue;
+    }
+    const TreeNode::TypeCase type = (TreeNode::TypeCase)tree_node->OneOfType("type");
+    MessageModel *resource = tree_node->GetSubModel<MessageModel*>(type);
+    R_ASSESS_C(resource);
+    emit ModelAboutToBeDeleted(resource);
+    deletedResources.append({type, tree_node->Data(FieldPath::Of<TreeNode>(TreeNode::kNameFieldNumber)).toString()});
   }
 
-  for (auto& res : deletedResources)
-    emit ItemRemoved(res.first, res.second, removers);
+  emit ItemsRemoved(deletedResources, removers);
 
-  // done with removers
+  // Each list drops its rows one contiguous range at a time. Hold the tree back until they all have, then rebuild
+  // every affected node once; that is also when views hear about the removals.
+  deferring_row_changes_ = true;
   removers.clear();
+  deferring_row_changes_ = false;
+  // Rebuild the deepest nodes first; rebuilding a parent may drop the nodes beneath it.
+  std::vector<std::pair<size_t, ProtoModel *>> changed;
+  for (ProtoModel *model : qAsConst(deferred_row_changes_)) {
+    if (Node *node = row_routes_.value(model)) changed.emplace_back(node->PathFromRoot().size(), model);
+  }
+  deferred_row_changes_.clear();
+  std::stable_sort(changed.begin(), changed.end(),
+                   [](const auto &a, const auto &b) { return a.first > b.first; });
+  for (const auto &[depth, model] : changed) RouteRowsChanged(model);
 }
 
 // =====================================================================================================================
@@ -337,45 +508,227 @@ TreeModel::Node::Node(TreeModel *backing_tree, Node *parent, int row_in_parent,
   RebuildFromModel(model, parent, row_in_parent);
 }
 
-void TreeModel::Node::RegisterDataListener() {
-  updaters.push_back(connect(backing_model, &PrimitiveModel::dataChanged, [this]{
-    if (!parent) backing_tree->beginResetModel();
-    RebuildFromAnyModel(backing_model, parent, row_in_parent);
+void TreeModel::Node::RegisterRowListeners() {
+  ClearListeners();
+  // Messages never gain or lose rows, but one whose buffer is replaced wholesale is reset and builds new submodels,
+  // which this node has to be rebuilt from. Its parent list only hears of that as a change to the row's data.
+  if (auto *message = SourceModel()->TryCastAsMessageModel()) {
+    routed_message = message;
+    backing_tree->Route(message, this);
+  }
+  if (IsRepeated()) {
+    routed_model = backing_model;
+    backing_tree->Route(backing_model, this);
+  }
+}
+
+void TreeModel::Node::RowsChanged() {
+  // Views still see the children from before the change. Rebuild quietly, then walk them through the difference.
+  // Children whose models survived are found in the model map and rebuilt in place.
+  const auto shown = children;
+  RebuildFromAnyModel(SourceModel(), parent, row_in_parent);
+  if (!parent) BuildChildren();
+  const auto rebuilt = children;
+  SetChildren(shown);
+  Reconcile(rebuilt);
+  if (parent) {
     UpdateParents();
-    if (parent) {
-      const QModelIndex ind = parent->index(row_in_parent);
-      emit backing_tree->dataChanged(ind, ind);
-    } else {
-      backing_tree->endResetModel();
-    }
-  }));
+    const QModelIndex ind = parent->index(row_in_parent);
+    emit backing_tree->dataChanged(ind, ind);
+    AddSelfToMap(passthrough_node);
+  } else {
+    backing_tree->RebuildModelMapping();
+  }
 }
 
-void TreeModel::Node::RegisterRowListeners() {
-  auto update = [this]{
-    QModelIndex ind;
-    if (parent) {
-      ind = parent->index(row_in_parent);
-      emit backing_tree->layoutAboutToBeChanged({ind});
-    } else {
-      backing_tree->beginResetModel();
+void TreeModel::Node::Reconcile(std::vector<std::shared_ptr<Node>> rebuilt) {
+  const bool was_reconciling = backing_tree->reconciling_;
+  backing_tree->reconciling_ = true;
+  const std::vector<std::shared_ptr<Node>> shown = children;
+  const QModelIndex self = IndexInTree();
+
+  // Pair each rebuilt child with the child views already know, if any. Nodes rebuilt in place pair with themselves.
+  std::unordered_map<Node *, int> shown_rows;
+  for (size_t row = 0; row < shown.size(); ++row) shown_rows[shown[row].get()] = row;
+  std::vector<bool> kept(shown.size(), false);
+  std::vector<std::shared_ptr<Node>> target(rebuilt.size());
+  for (size_t row = 0; row < rebuilt.size(); ++row) {
+    if (auto it = shown_rows.find(rebuilt[row].get()); it != shown_rows.end()) {
+      kept[it->second] = true;
+      target[row] = rebuilt[row];
     }
-    RecursiveUndoPassThrough();
-    this->RebuildFromAnyModel(backing_model, parent, row_in_parent);
-    if (parent) {
-      this->UpdateParents();
-      emit backing_tree->dataChanged(ind, ind);
-      emit backing_tree->layoutChanged({ind});
-    } else {
-      backing_tree->RebuildModelMapping();
-      backing_tree->endResetModel();
+  }
+  // The rest pair with a leftover child showing the same kind of thing under the same name, which takes over the
+  // rebuilt child's model.
+  QHash<QPair<QString, QString>, QVector<int>> leftovers;
+  for (size_t row = 0; row < shown.size(); ++row) {
+    if (!kept[row]) leftovers[shown[row]->Key()].append(row);
+  }
+  std::vector<std::pair<std::shared_ptr<Node>, std::vector<std::shared_ptr<Node>>>> adopted;
+  for (size_t row = 0; row < rebuilt.size(); ++row) {
+    if (target[row]) continue;
+    auto it = leftovers.find(rebuilt[row]->Key());
+    if (it == leftovers.end() || it->isEmpty()) {
+      target[row] = rebuilt[row];
+      continue;
     }
-    AddSelfToMap(passthrough_node);
-  };
-  updaters.push_back(connect(backing_model, &ProtoModel::rowsInserted, update));
-  updaters.push_back(connect(backing_model, &ProtoModel::modelReset, update));
-  updaters.push_back(connect(backing_model, &ProtoModel::rowsRemoved, update));
-  updaters.push_back(connect(backing_model, &ProtoModel::rowsMoved, update));
+    const int match = it->takeFirst();
+    kept[match] = true;
+    target[row] = shown[match];
+    adopted.emplace_back(shown[match], shown[match]->Adopt(*rebuilt[row]));
+  }
+  rebuilt.clear();
+
+  // Remove unpaired children, last to first so that earlier rows keep their numbers.
+  std::vector<std::shared_ptr<Node>> current = shown;
+  for (int last = int(shown.size()) - 1; last >= 0; --last) {
+    if (kept[last]) continue;
+    int first = last;
+    while (first > 0 && !kept[first - 1]) --first;
+    backing_tree->beginRemoveRows(self, first, last);
+    for (int row = first; row <= last; ++row) current[row]->RemoveSelfFromMap();
+    current.erase(current.begin() + first, current.begin() + last + 1);
+    SetChildren(current);
+    backing_tree->endRemoveRows();
+    last = first;
+  }
+
+  // Move the survivors into their new order.
+  std::vector<std::shared_ptr<Node>> order;
+  for (const auto &node : target) {
+    if (shown_rows.count(node.get())) order.push_back(node);
+  }
+  for (size_t row = 0; row < order.size(); ++row) {
+    if (current[row] == order[row]) continue;
+    const int from = std::find(current.begin() + row + 1, current.end(), order[row]) - current.begin();
+    backing_tree->beginMoveRows(self, from, from, self, row);
+    current.erase(current.begin() + from);
+    current.insert(current.begin() + row, order[row]);
+    SetChildren(current);
+    backing_tree->endMoveRows();
+  }
+
+  // Insert the new children around them.
+  for (int first = 0; first < int(target.size()); ++first) {
+    if (shown_rows.count(target[first].get())) continue;
+    int last = first;
+    while (last + 1 < int(target.size()) && !shown_rows.count(target[last + 1].get())) ++last;
+    backing_tree->beginInsertRows(self, first, last);
+    current.insert(current.begin() + first, target.begin() + first, target.begin() + last + 1);
+    SetChildren(current);
+    for (int row = first; row <= last; ++row) target[row]->AddSelfToMap(target[row]);
+    backing_tree->endInsertRows();
+    first = last;
+  }
+
+  for (auto &[node, grandchildren] : adopted) node->Reconcile(std::move(grandchildren));
+  backing_tree->reconciling_ = was_reconciling;
+}
+
+std::vector<std::shared_ptr<TreeModel::Node>> TreeModel::Node::Adopt(const Node &other) {
+  const bool was_populated = ChildSource()->populated;
+  const auto shown = children;
+  RemoveSelfFromMap();
+  RebuildFromAnyModel(other.SourceModel(), other.parent, other.row_in_parent);
+  row_in_model = other.row_in_model;
+  if (was_populated) BuildChildren();
+  const auto rebuilt = children;
+  SetChildren(shown);
+  return rebuilt;
+}
+
+ProtoModel *TreeModel::Node::SourceModel() const { return passthrough_model ? passthrough_model : backing_model; }
+
+QPair<QString, QString> TreeModel::Node::Key() const {
+  return {QString::fromStdString(GetMessageType()), display_name};
+}
+
+// =====================================================================================================================
+// == Change Routing ===================================================================================================
+// =====================================================================================================================
+
+void TreeModel::Route(ProtoModel *model, Node *node) {
+  row_routes_.insert(model, node);
+  // Retiring or destroying a model drops its connections, which invalidates the ones we keep.
+  auto subscription = subscriptions_.find(model);
+  if (subscription != subscriptions_.end() && subscription->first()) return;
+  if (subscription == subscriptions_.end()) subscription = subscriptions_.insert(model, {});
+  subscription->clear();
+  auto rows_changed = [this, model]() { RouteRowsChanged(model); };
+  subscription->append(connect(model, &ProtoModel::modelReset, this, rows_changed));
+  // The rows of a message are its fields, which don't line up with the node's children.
+  if (model->TryCastAsMessageModel()) return;
+  subscription->append(connect(model, &ProtoModel::rowsInserted, this, rows_changed));
+  subscription->append(connect(model, &ProtoModel::rowsRemoved, this, rows_changed));
+  subscription->append(connect(model, &ProtoModel::RowsDropped, this, rows_changed));
+  subscription->append(connect(model, &ProtoModel::rowsMoved, this, rows_changed));
+  subscription->append(connect(model, &ProtoModel::dataChanged, this,
+                               [this, model](const QModelIndex &top_left, const QModelIndex &bottom_right) {
+                                 RouteDataChanged(model, top_left, bottom_right);
+                               }));
+}
+
+void TreeModel::Unroute(ProtoModel *model, Node *node) {
+  auto it = row_routes_.find(model);
+  if (it == row_routes_.end() || *it != node) return;
+  row_routes_.erase(it);
+  // Rebuilding a node unroutes its models only to route them again right away, so the subscription is kept until the
+  // event loop comes around, and only dropped if no node has claimed the model by then.
+  unrouted_.insert(model);
+  if (prune_scheduled_) return;
+  prune_scheduled_ = true;
+  QTimer::singleShot(0, this, &TreeModel::PruneSubscriptions);
+}
+
+void TreeModel::PruneSubscriptions() {
+  prune_scheduled_ = false;
+  for (ProtoModel *model : qAsConst(unrouted_)) {
+    if (row_routes_.contains(model)) continue;
+    auto subscription = subscriptions_.find(model);
+    if (subscription == subscriptions_.end()) continue;
+    // The model may be gone by now, in which case these are already disconnected.
+    for (const auto &connection : qAsConst(*subscription)) disconnect(connection);
+    subscriptions_.erase(subscription);
+  }
+  unrouted_.clear();
+}
+
+void TreeModel::RouteRowsChanged(ProtoModel *model) {
+  if (deferring_row_changes_) {
+    deferred_row_changes_.insert(model);
+    return;
+  }
+  if (Node *node = row_routes_.value(model)) node->RowsChanged();
+}
+
+void TreeModel::RouteDataChanged(ProtoModel *model, const QModelIndex &top_left, const QModelIndex &bottom_right) {
+  if (!row_routes_.contains(model)) return;
+  const int first = top_left.row(), last = bottom_right.row();
+  if (first < 0 || last < first) return;
+  if (auto it = pending_data_changes_.find(model); it != pending_data_changes_.end()) {
+    it->first = std::min(it->first, first);
+    it->second = std::max(it->second, last);
+  } else {
+    pending_data_changes_.insert(model, {first, last});
+  }
+  if (data_flush_scheduled_) return;
+  data_flush_scheduled_ = true;
+  QTimer::singleShot(0, this, &TreeModel::FlushDataChanges);
+}
+
+void TreeModel::FlushDataChanges() {
+  data_flush_scheduled_ = false;
+  QHash<ProtoModel*, QPair<int, int>> changes;
+  changes.swap(pending_data_changes_);
+  for (auto it = changes.cbegin(); it != changes.cend(); ++it) {
+    // The node may have been rebuilt or released since; only rows it still has are refreshed.
+    Node *node = row_routes_.value(it.key());
+    if (!node) continue;
+    const int first = it->first, last = std::min<int>(it->second, node->children.size() - 1);
+    if (first > last) continue;
+    for (int row = first; row <= last; ++row) node->children[row]->DataChanged();
+    emit dataChanged(node->index(first), node->index(last));
+  }
 }
 
 
@@ -393,8 +746,7 @@ void TreeModel::Node::RebuildFromModel(MessageModel *model, Node *parent, int ro
   const auto &tree_meta = backing_tree->GetTreeDisplay(model->GetDescriptor()->full_name());
   const auto &msg_meta = BackingModel()->GetMessageDisplay(model->GetDescriptor()->full_name());
   if (tree_meta.custom_editor) {
-    // Leaf node; connect the data change handler.
-    RegisterDataListener();
+    // Leaf node. Its parent list reports changes to it, so it needs no listener of its own.
     return;
   }
   for (int row = 0; row < model->rowCount(); ++row) {
@@ -407,9 +759,9 @@ void TreeModel::Node::RebuildFromModel(MessageModel *model, Node *parent, int ro
   }
   is_passthrough = tree_meta.is_passthrough;
   PassThrough();
-  // Nothing can modify rows of a MessageModel in a way that its TreeNode must handle.
-  // Example: you cannot insert or remove rows of a message model. Edits will be handled by child models.
-  // Register no data cchange handlers.
+  // Nothing can modify rows of a MessageModel in a way that its TreeNode must handle; edits are handled by child
+  // models. Only a reset, which replaces the submodels, has to be listened for. PassThrough() already registered.
+  if (!passthrough_node) RegisterRowListeners();
 }
 
 // Construct from Repeated Message Model.
@@ -426,12 +778,61 @@ TreeModel::Node::Node(TreeModel *backing_tree, Node *parent, int row_in_parent,
 void TreeModel::Node::RebuildFromModel(RepeatedMessageModel *model, Node *parent, int row_in_parent) {
   // qDebug() << "Rebuild " << DebugPath();
   Reset(model, parent, row_in_parent);
-  for (int row = 0; row < backing_model->rowCount(); ++row) {
-    PushChild(model->GetSubModel<ProtoModel>(row), row);
+  // Children are only built once a view has asked for them; see Populate().
+  if (populated) {
+    for (int row = 0; row < backing_model->rowCount(); ++row) {
+      PushChild(model->GetSubModel<ProtoModel>(row), row);
+    }
   }
   RegisterRowListeners();
 }
 
+const TreeModel::Node *TreeModel::Node::ChildSource() const {
+  const Node *node = this;
+  while (node->passthrough_node) node = node->passthrough_node.get();
+  return node;
+}
+
+bool TreeModel::Node::CanFetchMore() const {
+  return !ChildSource()->populated && backing_model->TryCastAsRepeatedMessageModel() && backing_model->rowCount() > 0;
+}
+
+void TreeModel::Node::Populate() {
+  if (ChildSource()->populated) return;
+  BuildChildren();
+  for (auto &child : children) child->AddSelfToMap(child);
+}
+
+void TreeModel::Node::BuildChildren() {
+  Node *source = ChildSource();
+  if (source->populated) return;
+  auto *const model = source->backing_model->TryCastAsRepeatedMessageModel();
+  R_EXPECT_V(model) << "Populating node `" << DebugPath() << "`, which is not a repeated message.";
+  source->populated = true;
+  for (int row = 0; row < model->rowCount(); ++row) {
+    source->PushChild(model->GetSubModel<ProtoModel>(row), row);
+  }
+  SetChildren(source->children);
+}
+
+void TreeModel::Node::SetChildren(std::vector<std::shared_ptr<Node>> nodes) {
+  // Passthrough nodes all share the children of the node they pass through to.
+  for (Node *node = this; node; node = node->passthrough_node.get()) node->children = nodes;
+  for (size_t row = 0; row < nodes.size(); ++row) {
+    for (Node *node = nodes[row].get(); node; node = node->passthrough_node.get()) {
+      node->parent = this;
+      node->row_in_parent = row;
+    }
+  }
+}
+
+void TreeModel::Node::Release() {
+  for (const auto &child : children) child->RemoveSelfFromMap();
+  Node *source = ChildSource();
+  for (Node *node = this; node; node = node->passthrough_node.get()) node->children.clear();
+  source->populated = false;
+}
+
 // Construct from Repeated Primitive Model (base RepeatedModel).
 TreeModel::Node::Node(TreeModel *backing_tree, Node *parent, int row_in_parent, RepeatedModel *model, int row_in_model)
     : backing_tree(backing_tree),
@@ -529,12 +930,14 @@ void TreeModel::Node::Print(int indent) const {
 TreeModel::Node::~Node() {
   if (auto it = backing_tree->live_nodes.find(this); it != backing_tree->live_nodes.end())
     backing_tree->live_nodes.erase(it);
+  for (const QString &name : qAsConst(awaited_icons)) backing_tree->icon_waiters_.remove(name, this);
   ClearListeners();
 }
 
 void TreeModel::Node::ClearListeners() {
-  for (const auto &connection : updaters) QObject::disconnect(connection);
-  updaters.clear();
+  if (routed_model) backing_tree->Unroute(routed_model, this);
+  if (routed_message) backing_tree->Unroute(routed_message, this);
+  routed_model = routed_message = nullptr;
 }
 void TreeModel::Node::UpdateParents() {
   for (Node *p = parent; p; p = p->parent)
@@ -621,6 +1024,21 @@ QModelIndex TreeModel::mapFromSource(const QModelIndex &source_index) const {
   return (*mapping)->mapFromSource(source_index);
 }
 
+QModelIndex TreeModel::fetchFromSource(const QModelIndex &source_index) {
+  if (!source_index.isValid() || !source_index.internalPointer()) return mapFromSource(source_index);
+  // Populate downward from the nearest ancestor with a node until the source model itself has been built.
+  for (;;) {
+    auto *model = static_cast<ProtoModel *>(source_index.internalPointer());
+    while (model && !backing_nodes_.contains(model)) model = model->GetParentModel();
+    R_EXPECT(model, QModelIndex()) << "Source index " << source_index << " does not belong to this tree.";
+    Node *node = backing_nodes_.value(model).get();
+    if (!node->CanFetchMore()) break;
+    fetchMore(node->IndexInTree());
+    R_EXPECT(!node->CanFetchMore(), QModelIndex()) << "Failed to populate tree node `" << node->DebugPath() << "`";
+  }
+  return mapFromSource(source_index);
+}
+
 QModelIndex TreeModel::mapToSource(const QModelIndex &proxyIndex) const {
   if (!proxyIndex.isValid()) return {};
   if (Node *n = IndexToNode(proxyIndex)) {
@@ -635,7 +1053,13 @@ QModelIndex TreeModel::mapToSource(const QModelIndex &proxyIndex) const {
 
 static const std::string kEmptyString;
 QString TreeModel::GetItemName(const Node *item) const { return item ? item->display_name : "<null>"; }
-QVariant TreeModel::GetItemIcon(const Node *item) const { return item ? item->display_icon : QVariant(); }
+QVariant TreeModel::GetItemIcon(Node *item) const { return item ? item->DisplayIcon() : QVariant(); }
+
+void TreeModel::IconLoaded(const QString &name) {
+  const QList<Node *> waiting = icon_waiters_.values(name);
+  icon_waiters_.remove(name);
+  for (Node *node : waiting) node->IconLoaded(name);
+}
 TreeModel::Node *TreeModel::GetNthChild(Node *item, int n) const { return item ? item->NthChild(n) : nullptr; }
 int TreeModel::GetChildCount(Node *item) const { return item ? item->children.size() : 0; }
 const std::string &TreeModel::GetMessageType(const Node *node) { return node ? node->GetMessageType() : kEmptyString; }
@@ -671,15 +1095,41 @@ void TreeModel::Node::ComputeDisplayData() {
       display_name += " = " + value.toString();
     }
   }
-  display_icon = display_model->GetDisplayIcon();
+  // Looking up the icon can mean decoding an image, so that waits until a view actually shows this node.
+  icon_stale = true;
 
   if (passthrough_node) {
-    if (display_icon.isNull() || display_name.isEmpty()) passthrough_node->ComputeDisplayData();
-    if (display_icon.isNull()) display_icon = passthrough_node->display_icon;
+    passthrough_node->ComputeDisplayData();
     if (display_name.isEmpty()) display_name = passthrough_node->display_name;
   }
 }
 
+const QIcon &TreeModel::Node::DisplayIcon() {
+  if (!icon_stale) return display_icon;
+  icon_stale = false;
+  ArtManager::DeferredLoads loads;
+  display_icon = SourceModel()->GetDisplayIcon();
+  if (display_icon.isNull() && passthrough_node) {
+    // Look again, so that anything the intermediate node still waits on is waited on here too.
+    passthrough_node->icon_stale = true;
+    display_icon = passthrough_node->DisplayIcon();
+  }
+  for (const QString &name : loads.Pending()) {
+    if (awaited_icons.contains(name)) continue;
+    awaited_icons.append(name);
+    backing_tree->icon_waiters_.insert(name, this);
+  }
+  return display_icon;
+}
+
+void TreeModel::Node::IconLoaded(const QString &name) {
+  if (!awaited_icons.removeOne(name)) return;
+  icon_stale = true;
+  if (!parent) return;
+  const QModelIndex index = IndexInTree();
+  emit backing_tree->dataChanged(index, index, {Qt::DecorationRole});
+}
+
 
 // =====================================================================================================================
 // == Data Management Helpers ==========================================================================================
@@ -699,7 +1149,7 @@ QModelIndex TreeModel::addNode(const Message &child, const QModelIndex &parent)
   if (parent.isValid()) {
     Node *parentNode = IndexToNode(parent);
     if (parentNode->IsRepeated()) {
-      pos = parentNode->children.size();
+      pos = parentNode->BackingModel()->rowCount();
     } else {
       insertParent = parent.parent();
       pos = parent.row();
@@ -712,19 +1162,10 @@ QModelIndex TreeModel::addNode(const Message &child, const QModelIndex &parent)
   return insert(insertParent, pos, child);
 }
 
-QModelIndex TreeModel::duplicateNode(const QModelIndex & index) {
-  Node *node = IndexToNode(index);
-  if (node->IsRepeated()) {
-    //return node->mapFromSource(node->repeated_model->duplicate(mapToSource(index)));
-  }
-  Node *parent = IndexToNode(index.parent());
-  return node->duplicate(parent, node->row_in_parent+1);
-}
-
-void TreeModel::sortByName(const QModelIndex & index) {
+void TreeModel::sortByName(const QModelIndex & index, bool natural, bool recursive) {
   auto node = IndexToNode(index);
   if (!node) return;
-  node->sort();
+  node->sort(natural, recursive);
 }
 
 void TreeModel::triggerNodeEdit(const QModelIndex &index, QAbstractItemView *view) {
@@ -748,32 +1189,136 @@ void TreeModel::triggerNodeEdit(const QModelIndex &index, QAbstractItemView *vie
   view->edit(index);
 }
 
-void TreeModel::Node::sort() {
-  if (!IsRepeated()) return;
-  auto *const model = passthrough_model ? passthrough_model : backing_model;
-  auto *const message_model = model->TryCastAsMessageModel();
-  auto *const buffer = static_cast<TreeNode*>(message_model->GetBuffer());
-  auto *child_field = buffer->mutable_folder()->mutable_children();
-  std::sort(child_field->begin(), child_field->end(),
-            [](const TreeNode &a, const TreeNode &b) { return a.name() < b.name(); });
-  RebuildFromAnyModel(model, parent, row_in_parent);
-  AddSelfToMap(passthrough_node);
+// Folders with at least this many children are sorted on the thread pool.
+static constexpr int kParallelSortThreshold = 4096;
+
+static QStringList ChildNames(RepeatedMessageModel *rows) {
+  QStringList names;
+  names.reserve(rows->rowCount());
+  for (int row = 0; row < rows->rowCount(); ++row) {
+    auto *const child = static_cast<const TreeNode *>(rows->GetSubModel<MessageModel*>(row)->GetBuffer());
+    names.append(QString::fromStdString(child->name()));
+  }
+  return names;
+}
+
+// Returns the row each name belongs at: the name at order[i] goes to row i. Equal names keep their relative order.
+static std::vector<int> SortedOrder(const QStringList &names, bool natural) {
+  // Collating is the expensive part of comparing two names, so each name is only collated once.
+  QCollator collator;
+  collator.setNumericMode(natural);
+  std::vector<QCollatorSortKey> keys;
+  keys.reserve(names.size());
+  for (const QString &name : names) keys.push_back(collator.sortKey(name));
+
+  std::vector<int> order(names.size());
+  std::iota(order.begin(), order.end(), 0);
+  auto less = [&keys](int a, int b) { return keys[a].compare(keys[b]) < 0; };
+  if (names.size() < kParallelSortThreshold) {
+    std::stable_sort(order.begin(), order.end(), less);
+    return order;
+  }
+
+  // Sort one slice per thread, then merge neighbouring slices until one is left. Both steps are stable.
+  const int slices = std::max(2, QThread::idealThreadCount());
+  std::vector<std::pair<int, int>> bounds;
+  for (int i = 0; i < slices; ++i)
+    bounds.emplace_back(qint64(names.size()) * i / slices, qint64(names.size()) * (i + 1) / slices);
+  QtConcurrent::blockingMap(bounds, [&order, &less](const std::pair<int, int> &slice) {
+    std::stable_sort(order.begin() + slice.first, order.begin() + slice.second, less);
+  });
+  while (bounds.size() > 1) {
+    std::vector<std::array<int, 3>> merges;
+    std::vector<std::pair<int, int>> merged;
+    for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+      merges.push_back({bounds[i].first, bounds[i].second, bounds[i + 1].second});
+      merged.emplace_back(bounds[i].first, bounds[i + 1].second);
+    }
+    if (bounds.size() % 2) merged.push_back(bounds.back());
+    QtConcurrent::blockingMap(merges, [&order, &less](const std::array<int, 3> &merge) {
+      std::inplace_merge(order.begin() + merge[0], order.begin() + merge[1], order.begin() + merge[2], less);
+    });
+    bounds = std::move(merged);
+  }
+  return order;
+}
+
+// Sorts a folder (and everything in it) that has no nodes built for its contents.
+static void SortFolderRows(RepeatedMessageModel *rows, bool natural) {
+  rows->PermuteRows(SortedOrder(ChildNames(rows), natural));
+  for (int row = 0; row < rows->rowCount(); ++row) {
+    MessageModel *const child = rows->GetSubModel<MessageModel*>(row);
+    auto *const folder = child->GetSubModel<MessageModel*>(TreeNode::kFolderFieldNumber);
+    if (!folder) continue;
+    if (auto *const children = folder->GetSubModel<RepeatedMessageModel*>(TreeNode::Folder::kChildrenFieldNumber))
+      SortFolderRows(children, natural);
+  }
+}
+
+void TreeModel::Node::sort(bool natural, bool recursive) {
+  auto *const rows = backing_model->TryCastAsRepeatedMessageModel();
+  if (!rows) return;
+  if (children.empty()) {
+    // Nothing is shown yet, so there is nothing to tell views.
+    if (recursive) {
+      SortFolderRows(rows, natural);
+    } else {
+      rows->PermuteRows(SortedOrder(ChildNames(rows), natural));
+    }
+    return;
+  }
+
+  const std::vector<int> order = SortedOrder(ChildNames(rows), natural);
+  R_EXPECT_V(order.size() == children.size()) << "Sorting " << DebugPath() << ", which is out of sync with its model";
+
+  // The nodes move along with their rows, so views keep them expanded and selected.
+  QList<QPersistentModelIndex> parents;
+  if (parent) parents.append(IndexInTree());
+  emit backing_tree->layoutAboutToBeChanged(parents, QAbstractItemModel::VerticalSortHint);
+  rows->PermuteRows(order);
+  std::vector<std::shared_ptr<Node>> sorted;
+  sorted.reserve(order.size());
+  for (int row : order) sorted.push_back(children[row]);
+  SetChildren(std::move(sorted));
+  std::vector<int> new_rows(order.size());
+  for (size_t row = 0; row < order.size(); ++row) {
+    children[row]->row_in_model = row;
+    new_rows[order[row]] = row;
+  }
+  const QModelIndexList persistent = backing_tree->persistentIndexList();
+  for (const QModelIndex &index : persistent) {
+    if (index.internalPointer() == this) backing_tree->changePersistentIndex(index, this->index(new_rows[index.row()]));
+  }
+  emit backing_tree->layoutChanged(parents, QAbstractItemModel::VerticalSortHint);
+
+  if (!recursive) return;
+  for (const auto &child : children) child->sort(natural, recursive);
 }
 
 QModelIndex TreeModel::Node::insert(const Message &message, int row) {
   auto *const repeated_message_model = backing_model->TryCastAsRepeatedMessageModel();
   R_EXPECT(repeated_message_model, QModelIndex()) << "Insert " << message.DebugString().c_str();
+  // The new row can only be mapped once its siblings have been built.
+  if (CanFetchMore())
+    backing_tree->fetchMore(IndexInTree());
+  else
+    Populate();
   return backing_tree->mapFromSource(repeated_message_model->insert(message, row));
 }
 
-QModelIndex TreeModel::Node::duplicate(Node* newParent, int row) {
-  return newParent->insert(GetMessage(), row);
-}
-
 bool TreeModel::Node::IsRepeated() const { return backing_model->TryCastAsRepeatedModel(); }
 
 ProtoModel *TreeModel::Node::BackingModel() const { return backing_model; }
 
+QModelIndex TreeModel::Node::IndexInTree() const { return parent ? parent->index(row_in_parent) : QModelIndex(); }
+
+std::vector<int> TreeModel::Node::PathFromRoot() const {
+  std::vector<int> path;
+  for (const Node *node = this; node->parent; node = node->parent) path.push_back(node->row_in_parent);
+  std::reverse(path.begin(), path.end());
+  return path;
+}
+
 const TreeModel::TreeNodeDisplayConfig &TreeModel::DisplayConfig::GetTreeDisplay(
     const std::string &message_qname) const {
   static const TreeModel::TreeNodeDisplayConfig sentinel;
@@ -14,6 +14,7 @@
 #include <QVector>
 
 #include <memory>
+#include <utility>
 #include <unordered_map>
 
 using TypeCase = buffers::TreeNode::TypeCase;
@@ -54,14 +55,22 @@ class TreeModel : public QAbstractItemModel {
     /// For nodes whose child was a single passthrough node with a single child,
     /// this is the original model this node would behave as (instead, it behaves as its passthrough child).
     ProtoModel *passthrough_model = nullptr;
-    /// The signal connection that updates this node when data changes, if applicable.
-    /// Stored only for leaf nodes.
-    std::vector<QMetaObject::Connection> updaters;
+    /// The repeated model whose row changes the tree routes to this node, if any. See TreeModel::Route().
+    ProtoModel *routed_model = nullptr;
+    /// The message model whose resets the tree routes to this node, if any.
+    ProtoModel *routed_message = nullptr;
+    /// Whether children have been built for the rows of this node's repeated message model.
+    /// Nodes for repeated messages are populated lazily, as views fetch them, and survive rebuilds of the node.
+    bool populated = false;
+    /// Whether display_icon has to be looked up again before it is shown.
+    bool icon_stale = true;
+    /// Images display_icon has placeholders for. The tree calls IconLoaded() as each finishes loading.
+    QStringList awaited_icons;
 
    public:
     /// Cache of the name (or value) field of the underlying proto.
     QString display_name;
-    /// Cache of the icon field or per-message display icon of the underlying proto.
+    /// Cache of the icon field or per-message display icon of the underlying proto. Use DisplayIcon(), which fills it.
     QIcon display_icon;
     /// Generally a cache of this node's position in its parent Node's list of children (parent->children).
     /// This may not correspond 1:1 with the field mapping in the model. Use `row_in_model` for that.
@@ -76,14 +85,20 @@ class TreeModel : public QAbstractItemModel {
     std::vector<std::shared_ptr<Node>> children;
 
     bool SetName(const QString &name, const ProtoModel::MessageDisplayConfig &meta);
+    /// Returns this node's icon, looking it up if it isn't cached. Images which would have to be decoded to do so are
+    /// loaded in the background; the node shows a placeholder until IconLoaded() is called for each of them.
+    const QIcon &DisplayIcon();
+    /// Drops the cached icon, and tells views to ask again, if it was waiting on the given image.
+    void IconLoaded(const QString &name);
     Node *NthChild(int n) const;
     const std::string &GetMessageType() const;
     TreeNode GetMessage() const;
     QModelIndex mapFromSource(const QModelIndex &index) const;
-    void sort();
+    /// Sorts the children of this node by name, according to the user's locale. Natural sorting compares runs of
+    /// digits by their value, so that "room2" comes before "room10".
+    void sort(bool natural = false, bool recursive = false);
     QModelIndex index(int row) const;
     QModelIndex insert(const Message &message, int row);
-    QModelIndex duplicate(Node* newParent, int row);
 
     /// Build a string representation of this node's position in the tree (a concatenation of display_names).
     QString DebugPath() const;
@@ -91,6 +106,19 @@ class TreeModel : public QAbstractItemModel {
     /// Returns whether this node represents a repeated field.
     bool IsRepeated() const;
     ProtoModel *BackingModel() const;
+    /// Returns the model this node was built from, before any passthrough.
+    ProtoModel *SourceModel() const;
+    /// Returns the index of this node in the tree, or the root index for the root node.
+    QModelIndex IndexInTree() const;
+    /// Returns the row of each node from just below the root down to this one. Sorting paths puts nodes in tree order.
+    std::vector<int> PathFromRoot() const;
+
+    /// Returns whether this node has message rows which have not been built into child nodes yet.
+    bool CanFetchMore() const;
+    /// Builds a child node for every row of this node's repeated message model. Does nothing if already populated.
+    void Populate();
+    /// Destroys the children of this node, leaving it to be populated again when it is next expanded.
+    void Release();
 
     /// Debug print.
     void Print(int indent = 0) const;
@@ -125,19 +153,40 @@ class TreeModel : public QAbstractItemModel {
     void RecursiveUndoPassThrough();
 
     void DataChanged();
+    /// Rebuilds this node after rows were inserted, removed, moved or reset in its repeated model, or its message model
+    /// was reset, then tells views about the difference.
+    void RowsChanged();
+    /// Turns the children views currently see into the given rebuilt children, one insert, remove or move at a time.
+    /// Rebuilt children which show the same thing as an existing child are merged into the existing node, so that
+    /// views keep it expanded and selected.
+    void Reconcile(std::vector<std::shared_ptr<Node>> rebuilt);
 
    private:
+    /// Follows passthrough nodes down to the node which actually builds this node's children.
+    const Node *ChildSource() const;
+    Node *ChildSource() { return const_cast<Node *>(std::as_const(*this).ChildSource()); }
+    /// Removes this node and everything below it from the containing tree's model map.
+    void RemoveSelfFromMap();
+    /// Populates the children of this node without adding them to the model map.
+    void BuildChildren();
+    /// Replaces the children of this node and of the passthrough nodes below it, renumbering them.
+    void SetChildren(std::vector<std::shared_ptr<Node>> nodes);
+    /// Identifies what this node shows, for matching it against a rebuilt node. Only uses cached data.
+    QPair<QString, QString> Key() const;
+    /// Rebuilds this node from the model of the given node, returning the rebuilt children.
+    /// The children views currently see are left in place for Reconcile().
+    std::vector<std::shared_ptr<Node>> Adopt(const Node &other);
+
     void PushChild(ProtoModel *model, int source_row);
     void ComputeDisplayData();
     void Reset(ProtoModel *model, Node *parent, int row_in_parent);
 
     /// Rebuilds parent nodes' display data.
     void UpdateParents();
-    /// Removes active listeners so that they can be repopulated for a new model.
+    /// Stops routing model changes to this node so that it can be registered for a new model.
     void ClearListeners();
-    /// Listens for data change events to the given model and rebuilds.
-    void RegisterDataListener();
-    /// Listens for row insert/move/delete operations on the given model and rebuilds.
+    /// Has the tree route row insert/move/delete operations on this node's repeated model, and resets of its message
+    /// model, to RowsChanged().
     void RegisterRowListeners();
   };
 
@@ -204,24 +253,30 @@ class TreeModel : public QAbstractItemModel {
   QModelIndex parent(const QModelIndex &index) const override;
   int rowCount(const QModelIndex &parent = QModelIndex()) const override;
   int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+  bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+  bool canFetchMore(const QModelIndex &parent) const override;
+  void fetchMore(const QModelIndex &parent) override;
+
+  /// Fetches every node below the given index. Only for operations which really need the whole subtree.
+  void fetchAll(const QModelIndex &parent = QModelIndex());
+  /// Destroys the nodes below the given index, which should be collapsed. Views fetch them again when expanded.
+  void releaseChildren(const QModelIndex &index);
 
   QModelIndex mapFromSource(const QModelIndex &sourceIndex) const;
+  /// Like mapFromSource(), but first fetches any ancestors of the source index which have not been populated yet.
+  QModelIndex fetchFromSource(const QModelIndex &sourceIndex);
   QModelIndex mapToSource(const QModelIndex &proxyIndex) const;
 
   /// Inserts the given message as a child of the given parent index.
   QModelIndex insert(const QModelIndex &parent, int row, const Message &message);
   /// Inserts the given message as a child of the given parent index.
   QModelIndex addNode(const Message &child, const QModelIndex &parent);
-  /// Duplicates the given node, placing it immediately after the original in sequence.
-  /// Does NOT launch an editor. To launch the appropriate editor (or simply trigger a rename of the duplicated node),
-  /// call triggerNodeEdit() on the result.
-  QModelIndex duplicateNode(const QModelIndex &index);
   /// Begins editing the specified node in the UI. For label-only nodes, such as folders, this is a rename.
   /// For valued nodes, launches the specified editor or begins editing the value column.
   void triggerNodeEdit(const QModelIndex &index, QAbstractItemView *view);
   /// Erases the node at the given index from the model. Triggers the appropriate events on the backing model,
   /// Sorts the data in the specified node alphabetically. Fires the appropriate events on the backing model.
-  void sortByName(const QModelIndex &index);
+  void sortByName(const QModelIndex &index, bool natural = false, bool recursive = false);
 
   // Mimedata stuff required for Drag & Drop and clipboard functions
   Qt::DropActions supportedDropActions() const override;
@@ -245,14 +300,43 @@ class TreeModel : public QAbstractItemModel {
   void ItemRenamed(TreeNode::TypeCase type, const QString &oldName, const QString &newName);
   // Called when a resource (or group of resources) is moved.
   void ItemMoved(TreeModel::Node *node, TreeNode *old_parent);
-  // Called when a resource (or group of resources) is removed.
-  void ItemRemoved(TreeNode::TypeCase type, const QString &name, std::map<ProtoModel*,
-                   RepeatedMessageModel::RowRemovalOperation>& removers);
+  // Called once per BatchRemove with every resource about to be removed, including those inside removed groups.
+  // Listeners may queue more rows to remove alongside them.
+  void ItemsRemoved(const QVector<QPair<TreeNode::TypeCase, QString>> &resources,
+                    std::map<ProtoModel*, RepeatedMessageModel::RowRemovalOperation>& removers);
   void ModelAboutToBeDeleted(MessageModel *m);
 
  private:
   /// Set of all living nodes belonging to this tree.
   std::set<Node*> live_nodes;
+
+  // Change routing. Nodes do not connect to their models themselves; the tree subscribes once to each repeated model
+  // it displays, and to the resets of each message shown with children, and hands changes to whichever node currently
+  // shows that model. Leaf nodes need no subscription, because every model forwards its changes to its parent list as
+  // a change to its own row.
+  // Warning: nodes unregister themselves on destruction, so these must be declared before anything holding nodes.
+
+  /// The node currently responsible for the rows of each repeated model, or the resets of each message model.
+  QHash<ProtoModel*, Node*> row_routes_;
+  /// The connections to each subscribed model; the first tells whether the subscription is still alive.
+  /// Subscriptions outlive the nodes that requested them, so rebuilding nodes doesn't reconnect anything. They are
+  /// dropped once no node has used the model for a turn of the event loop.
+  QHash<ProtoModel*, QList<QMetaObject::Connection>> subscriptions_;
+  /// Models unrouted since the last PruneSubscriptions().
+  QSet<ProtoModel*> unrouted_;
+  bool prune_scheduled_ = false;
+  /// Rows of each routed model whose display data changed since the last flush.
+  QHash<ProtoModel*, QPair<int, int>> pending_data_changes_;
+  bool data_flush_scheduled_ = false;
+  /// Nodes showing a placeholder icon, by the image they are waiting on.
+  QMultiHash<QString, Node*> icon_waiters_;
+  /// While set, row changes are only collected, to be routed once a batch of removals is complete.
+  bool deferring_row_changes_ = false;
+  QSet<ProtoModel*> deferred_row_changes_;
+  /// Set while views are walked through a structural change. Nodes they are about to lose may still refer to models
+  /// which have already been retired.
+  bool reconciling_ = false;
+
   /// Map from backing model to the node representing it.
   QHash<ProtoModel*, std::shared_ptr<Node>> backing_nodes_;
 
@@ -263,15 +347,43 @@ class TreeModel : public QAbstractItemModel {
   // Warning: this must be initialized *after* the above two maps.
   std::shared_ptr<Node> root_;
   MessageModel *root_model_;
+  /// Identifies this tree in drag data, so paths dragged out of another (or a since closed) tree are never resolved
+  /// here.
+  const quint64 drag_token_;
 
   QString GetItemName(const Node *item) const;
   bool SetItemName(Node *item, const QString &name);
-  QVariant GetItemIcon(const Node *item) const;
+  QVariant GetItemIcon(Node *item) const;
+  void IconLoaded(const QString &name);
   Node *GetNthChild(Node *item, int n) const;
   int GetChildCount(Node *item) const;
   const std::string &GetMessageType(const Node *node);
 
   void RebuildModelMapping();
+  /// Moves the given nodes, in order, to the given row of the given repeated node without copying their data.
+  /// Returns false, having changed nothing, if any of them cannot be moved that way.
+  bool MoveNodes(const QModelIndexList &indexes, Node *parent_node, int row);
+  // Returns the nodes at the given indexes in tree order, minus any inside another one of them.
+  std::vector<Node *> OutermostNodes(const QSet<const QModelIndex> &indexes) const;
+  enum class DecodedPaths {
+    kForeign,   // The data was not written by this tree.
+    kStale,     // Written by this tree, but some path no longer leads to a node.
+    kResolved,  // Every path was resolved.
+  };
+  // Resolves the node paths written by mimeData. Only fills in `indexes` if every path resolves.
+  DecodedPaths DecodeTreePaths(const QMimeData *mimeData, QModelIndexList *indexes) const;
+
+  /// Routes row and data changes of the given repeated model, or resets of the given message model, to the given
+  /// node, subscribing to it if needed.
+  void Route(ProtoModel *model, Node *node);
+  /// Stops routing changes of the given model, if they are still being routed to the given node.
+  void Unroute(ProtoModel *model, Node *node);
+  /// Drops the subscriptions of unrouted models which no node has claimed since.
+  void PruneSubscriptions();
+  void RouteRowsChanged(ProtoModel *model);
+  /// Queues a display update for the given rows. Updates are coalesced into one dataChanged per node.
+  void RouteDataChanged(ProtoModel *model, const QModelIndex &top_left, const QModelIndex &bottom_right);
+  void FlushDataChanges();
 
   // Retrieve field metadata for a tree. Returns a sentinel if not specified.
   const TreeNodeDisplayConfig &GetTreeDisplay(const std::string &message_qname) const;
@@ -1,32 +1,36 @@
 #include "TreeSortFilterProxyModel.h"
-#include "ProtoModel.h"
-
-TreeSortFilterProxyModel::TreeSortFilterProxyModel(QObject *parent) : QSortFilterProxyModel(parent) {}
+#include "MainWindow.h"
+#include "Models/ResourceModelMap.h"
+#include "Models/TreeModel.h"
+
+#include <QTimer>
+
+TreeSortFilterProxyModel::TreeSortFilterProxyModel(QObject *parent) : QSortFilterProxyModel(parent) {
+  if (!MainWindow::resourceMap) return;
+  // A folder is shown or hidden when its first resource of our type arrives or its last one goes. Bursts of those
+  // (such as loading a project) only filter the tree once.
+  connect(MainWindow::resourceMap, &ResourceModelMap::TypePresenceChanged, this, [this](int type) {
+    if (type != filterType || refilterScheduled) return;
+    refilterScheduled = true;
+    QTimer::singleShot(0, this, [this]() {
+      refilterScheduled = false;
+      invalidateFilter();
+    });
+  });
+}
 
 
 void TreeSortFilterProxyModel::SetFilterType(TreeNode::TypeCase type) {
   filterType = type;
-}
-
-inline bool recHasType(TreeNode& n, TreeNode::TypeCase type) {
-  if (!n.has_folder()) return false;
-  for (auto child : n.folder().children()) {
-    if (child.type_case() == TreeNode::kFolder) return recHasType(child, type);
-    if (child.type_case() == type) return true;
-  }
-  return false;
+  invalidateFilter();
 }
 
 bool TreeSortFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const {
 
   if (filterType == TreeNode::TYPE_NOT_SET) return true;
 
-  QModelIndex idx = sourceModel()->index(sourceRow, 0, sourceParent);
-  buffers::TreeNode *item = static_cast<buffers::TreeNode *>(idx.internalPointer());
-
-  if (item->has_folder() && item->folder().children_size() > 0) {
-    return recHasType(*item, filterType);
-  }
-
-  return item->type_case() == filterType;
+  auto *tree = qobject_cast<const TreeModel *>(sourceModel());
+  if (!tree || !MainWindow::resourceMap) return false;
+  const TreeModel::Node *node = tree->IndexToNode(tree->index(sourceRow, 0, sourceParent));
+  return node && MainWindow::resourceMap->ContainsType(node->SourceModel(), filterType);
 }
@@ -5,6 +5,7 @@
 
 #include <QSortFilterProxyModel>
 
+// Shows only the resources of one type, and the folders containing any. Meant to sit on top of a TreeModel.
 class TreeSortFilterProxyModel : public QSortFilterProxyModel
 {
 public:
@@ -14,6 +15,9 @@ public:
 protected:
   TreeNode::TypeCase filterType = TreeNode::TypeCase::TYPE_NOT_SET;
   bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+
+private:
+  bool refilterScheduled = false;
 };
 
 #endif // TREESORTFILTERPROXYMODEL_H
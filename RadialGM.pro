@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui printsupport multimedia testlib
+QT       += core gui printsupport multimedia concurrent testlib
 CONFIG   += c++17
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
@@ -67,6 +67,8 @@ SOURCES += \
     Dialogs/KeybindingPreferences.cpp \
     Dialogs/EventArgumentsDialog.cpp \
     Dialogs/TimelineChangeMoment.cpp \
+    Dialogs/DependencyReportDialog.cpp \
+    Dialogs/QuickOpenDialog.cpp \
     Editors/InformationEditor.cpp \
     Editors/IncludeEditor.cpp \
     Editors/ShaderEditor.cpp \
@@ -79,6 +81,8 @@ SOURCES += \
     Models/RepeatedMessageModel.cpp \
     Models/RepeatedModel.cpp \
     Models/RepeatedSortFilterProxyModel.cpp \
+    Models/ResourceIdColumn.cpp \
+    Models/ObjectSpriteCache.cpp \
     Utils/FieldPath.cpp \
     Utils/ProtoManip.cpp \
     Widgets/AssetScrollAreaBackground.cpp \
@@ -103,8 +107,14 @@ SOURCES += \
     Widgets/ColorPicker.cpp \
     Widgets/AssetView.cpp \
     Widgets/RoomView.cpp \
+    Widgets/ProjectSearchDock.cpp \
     Models/TreeModel.cpp \
     Components/ArtManager.cpp \
+    Components/ProjectSnapshots.cpp \
+    Components/ProjectSearchIndex.cpp \
+    Components/FuzzyResourceIndex.cpp \
+    Components/ThumbnailService.cpp \
+    Components/DependencyAnalyzer.cpp \
     Models/ProtoModel.cpp \
     Models/ImmediateMapper.cpp \
     Components/Utility.cpp \
@@ -122,6 +132,8 @@ HEADERS += \
     Dialogs/KeybindingPreferences.h \
     Dialogs/EventArgumentsDialog.h \
     Dialogs/TimelineChangeMoment.h \
+    Dialogs/DependencyReportDialog.h \
+    Dialogs/QuickOpenDialog.h \
     Editors/InformationEditor.h \
     Editors/IncludeEditor.h \
     Editors/ShaderEditor.h \
@@ -146,6 +158,8 @@ HEADERS += \
     Models/RepeatedModel.h \
     Models/RepeatedPrimitiveModel.h \
     Models/RepeatedSortFilterProxyModel.h \
+    Models/ResourceIdColumn.h \
+    Models/ObjectSpriteCache.h \
     Utils/FieldPath.h \
     Utils/ProtoManip.h \
     Utils/QBoilerplate.h \
@@ -159,10 +173,17 @@ HEADERS += \
     Widgets/PathView.h \
     Widgets/ResourceSelector.h \
     Widgets/RoomView.h \
+    Widgets/ProjectSearchDock.h \
     Models/TreeModel.h \
     Components/Logger.h \
     Components/ArtManager.h \
+    Components/ProjectSnapshots.h \
+    Components/ProjectSearchIndex.h \
+    Components/FuzzyResourceIndex.h \
+    Components/ThumbnailService.h \
+    Components/DependencyAnalyzer.h \
     Models/ProtoModel.h \
+    Models/ProtoModelPool.h \
     Models/ImmediateMapper.h \
     Components/Utility.h \
     Plugins/RGMPlugin.h \
@@ -122,7 +122,7 @@ bool SetField(google::protobuf::MutableRepeatedFieldRef<google::protobuf::Messag
   return false;
 }
 
-static QString MessageMimeType(const google::protobuf::Descriptor *desc) {
+QString MessageMimeType(const google::protobuf::Descriptor *desc) {
   return QString::fromStdString("application/x-protobuf; messageType=\"" + desc->full_name() + "\"");
 }
 
@@ -116,6 +116,9 @@ bool SetField(google::protobuf::MutableRepeatedFieldRef<google::protobuf::Messag
 // == MIME Types =======================================================================================================
 // =====================================================================================================================
 
+/// Returns a standardized name for the mime type of the given message type.
+QString MessageMimeType(const google::protobuf::Descriptor *desc);
+
 /// Returns a standardized name for the mime type accepted by the given field, whether string, integer, or message.
 /// For message fields, only accepts exactly that message type.
 QString GetMimeType(const google::protobuf::FieldDescriptor *desc);
@@ -0,0 +1,90 @@
+#include "ProjectSearchDock.h"
+#include "Components/ProjectSearchIndex.h"
+
+#include <QElapsedTimer>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+enum ResultRoles { TypeRole = Qt::UserRole, NameRole };
+
+ProjectSearchDock::ProjectSearchDock(ProjectSearchIndex* index, QWidget* parent)
+    : QDockWidget(tr("Search"), parent), _index(index) {
+  setObjectName("searchDockWidget");
+
+  QWidget* contents = new QWidget(this);
+  QVBoxLayout* layout = new QVBoxLayout(contents);
+  layout->setContentsMargins(0, 0, 0, 0);
+
+  _query = new QLineEdit(contents);
+  _query->setPlaceholderText(tr("Search names and code in the project"));
+  _query->setClearButtonEnabled(true);
+  layout->addWidget(_query);
+
+  _results = new QTreeWidget(contents);
+  _results->setHeaderLabels({tr("Resource"), tr("Field"), tr("Line"), tr("Text")});
+  _results->setRootIsDecorated(false);
+  _results->setUniformRowHeights(true);
+  _results->header()->setStretchLastSection(true);
+  layout->addWidget(_results);
+
+  _status = new QLabel(contents);
+  layout->addWidget(_status);
+
+  setWidget(contents);
+
+  // Wait for a pause in typing rather than searching on every keystroke.
+  _searchTimer.setSingleShot(true);
+  _searchTimer.setInterval(150);
+  connect(&_searchTimer, &QTimer::timeout, this, &ProjectSearchDock::Search);
+  connect(_query, &QLineEdit::textChanged, &_searchTimer, qOverload<>(&QTimer::start));
+  connect(_index, &ProjectSearchIndex::Changed, &_searchTimer, qOverload<>(&QTimer::start));
+  // Results aren't kept up to date while the dock is hidden.
+  connect(this, &QDockWidget::visibilityChanged, &_searchTimer, [this](bool visible) {
+    if (visible) _searchTimer.start();
+  });
+  connect(_results, &QTreeWidget::itemActivated, this, &ProjectSearchDock::ItemActivated);
+}
+
+void ProjectSearchDock::Activate() {
+  show();
+  raise();
+  _query->setFocus();
+  _query->selectAll();
+}
+
+void ProjectSearchDock::Search() {
+  if (!isVisible()) return;
+  _results->clear();
+  const QString query = _query->text();
+  if (query.trimmed().isEmpty()) {
+    _status->clear();
+    return;
+  }
+  if (!_index->IsReady()) {
+    _status->setText(tr("Indexing project..."));
+    return;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  const auto hits = _index->Search(query);
+  const qint64 elapsed = timer.elapsed();
+
+  QList<QTreeWidgetItem*> items;
+  items.reserve(hits.size());
+  for (const auto& hit : hits) {
+    auto* item = new QTreeWidgetItem({hit.resourceName, hit.field, QString::number(hit.line + 1), hit.text});
+    item->setData(0, TypeRole, hit.type);
+    item->setData(0, NameRole, hit.resourceName);
+    items.append(item);
+  }
+  _results->addTopLevelItems(items);
+  _status->setText(tr("%n result(s) in %1 ms", "", hits.size()).arg(elapsed));
+}
+
+void ProjectSearchDock::ItemActivated(QTreeWidgetItem* item) {
+  emit ResourceActivated(item->data(0, TypeRole).toInt(), item->data(0, NameRole).toString());
+}
@@ -0,0 +1,38 @@
+#ifndef PROJECTSEARCHDOCK_H
+#define PROJECTSEARCHDOCK_H
+
+#include <QDockWidget>
+#include <QTimer>
+
+class ProjectSearchIndex;
+class QLabel;
+class QLineEdit;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+// Dock listing every line in the project that matches the search text. Activating a result asks for the resource
+// holding it to be opened.
+class ProjectSearchDock : public QDockWidget {
+  Q_OBJECT
+
+ public:
+  ProjectSearchDock(ProjectSearchIndex* index, QWidget* parent);
+
+  // Shows the dock and puts the cursor in the search box.
+  void Activate();
+
+ signals:
+  void ResourceActivated(int type, const QString& name);
+
+ private:
+  void Search();
+  void ItemActivated(QTreeWidgetItem* item);
+
+  ProjectSearchIndex* _index;
+  QLineEdit* _query;
+  QLabel* _status;
+  QTreeWidget* _results;
+  QTimer _searchTimer;
+};
+
+#endif  // PROJECTSEARCHDOCK_H
@@ -3,23 +3,26 @@
 #include "Components/Logger.h"
 #include "MainWindow.h"
 #include "Models/MessageModel.h"
+#include "Models/ObjectSpriteCache.h"
 #include "Models/RepeatedMessageModel.h"
 #include "Models/RepeatedModel.h"
 
 #include <QDebug>
 #include <QPainter>
 
-bool InstanceSortFilterProxyModel::lessThan(const QModelIndex& left, const QModelIndex& right) const {
-  QVariant leftData = sourceModel()->data(left);
-  QVariant rightData = sourceModel()->data(right);
-
-  MessageModel* objA = MainWindow::resourceMap->GetResourceByName(TreeNode::kObject, leftData.toString());
-  MessageModel* objB = MainWindow::resourceMap->GetResourceByName(TreeNode::kObject, rightData.toString());
+InstanceSortFilterProxyModel::InstanceSortFilterProxyModel(QObject* parent)
+    : RepeatedSortFilterProxyModel(parent),
+      _objects(new ResourceIdColumn(TreeNode::kObject, Room::Instance::kObjectTypeFieldNumber, this)) {}
 
-  if (objA == nullptr || objB == nullptr) return false;
+void InstanceSortFilterProxyModel::SetSourceModel(RepeatedModel* sourceModel) {
+  // The column has to hear about changes before the proxy does, or it would sort by stale ids.
+  _objects->SetSourceModel(sourceModel ? sourceModel->TryCastAsRepeatedMessageModel() : nullptr);
+  RepeatedSortFilterProxyModel::SetSourceModel(sourceModel);
+}
 
-  objA = objA->GetSubModel<MessageModel*>(TreeNode::kObjectFieldNumber);
-  objB = objB->GetSubModel<MessageModel*>(TreeNode::kObjectFieldNumber);
+bool InstanceSortFilterProxyModel::lessThan(const QModelIndex& left, const QModelIndex& right) const {
+  MessageModel* objA = _objects->ResourceAt(left.row());
+  MessageModel* objB = _objects->ResourceAt(right.row());
 
   if (objA == nullptr || objB == nullptr) return false;
 
@@ -31,6 +34,12 @@ RoomView::RoomView(AssetScrollAreaBackground* parent) : AssetView(parent), _mode
   setFixedSize(RoomView::sizeHint());
   _sortedInstances = new InstanceSortFilterProxyModel(this);
   _sortedTiles = new RepeatedSortFilterProxyModel(this);
+  _tileBackgrounds = new ResourceIdColumn(TreeNode::kBackground, Room::Tile::kBackgroundNameFieldNumber, this);
+  _roomBackgrounds = new ResourceIdColumn(TreeNode::kBackground, Room::Background::kBackgroundNameFieldNumber, this);
+  // Paint only draws images which are already decoded, and repaints as the ones it skipped come in.
+  connect(ArtManager::Loader(), &ArtLoader::PixmapLoaded, this, [this](const QString& image) {
+    if (_awaitedImages.contains(image)) _parent->update();
+  });
 }
 
 void RoomView::SetResourceModel(MessageModel* model) {
@@ -39,8 +48,13 @@ void RoomView::SetResourceModel(MessageModel* model) {
   if (model != nullptr) {
     _sortedInstances->SetSourceModel(model->GetSubModel<RepeatedMessageModel*>(Room::kInstancesFieldNumber));
     _sortedInstances->sort(Room::Instance::kObjectTypeFieldNumber);
+    _tileBackgrounds->SetSourceModel(model->GetSubModel<RepeatedMessageModel*>(Room::kTilesFieldNumber));
     _sortedTiles->SetSourceModel(model->GetSubModel<RepeatedMessageModel*>(Room::kTilesFieldNumber));
     _sortedTiles->sort(Room::Tile::kDepthFieldNumber);
+    _roomBackgrounds->SetSourceModel(model->GetSubModel<RepeatedMessageModel*>(Room::kBackgroundsFieldNumber));
+  } else {
+    _tileBackgrounds->SetSourceModel(nullptr);
+    _roomBackgrounds->SetSourceModel(nullptr);
   }
   setFixedSize(sizeHint());
   repaint();
@@ -55,6 +69,7 @@ QSize RoomView::sizeHint() const {
 
 void RoomView::Paint(QPainter& painter) {
   _grid.type = GridType::Standard;
+  _awaitedImages.clear();
 
   if (!_model) return;
 
@@ -82,11 +97,7 @@ void RoomView::Paint(QPainter& painter) {
 
 void RoomView::paintTiles(QPainter& painter) {
   for (int row = 0; row < _sortedTiles->rowCount(); row++) {
-    QVariant bkgName = _sortedTiles->Data(
-        FieldPath::Of<Room::Tile>(FieldPath::StartingAt(row), Room::Tile::kBackgroundNameFieldNumber));
-    MessageModel* bkg = MainWindow::resourceMap->GetResourceByName(TreeNode::kBackground, bkgName.toString());
-    if (!bkg) continue;
-    bkg = bkg->GetSubModel<MessageModel*>(TreeNode::kBackgroundFieldNumber);
+    MessageModel* bkg = _tileBackgrounds->ResourceAt(_sortedTiles->SourceRow(row));
     if (!bkg) continue;
 
     int x =
@@ -110,8 +121,11 @@ void RoomView::paintTiles(QPainter& painter) {
         FieldPath::Of<Room::Tile>(FieldPath::StartingAt(row), Room::Tile::kYscaleFieldNumber));
 
     QString imgFile = bkg->Data(FieldPath::Of<Background>(Background::kImageFieldNumber)).toString();
-    QPixmap pixmap = ArtManager::GetCachedPixmap(imgFile);
-    if (pixmap.isNull()) continue;
+    QPixmap pixmap = ArtManager::FindCachedPixmap(imgFile);
+    if (pixmap.isNull()) {
+      _awaitedImages.insert(imgFile);
+      continue;
+    }
 
     QRectF dest(x, y, w, h);
     QRectF src(xOff, yOff, w, h);
@@ -133,15 +147,9 @@ void RoomView::paintBackgrounds(QPainter& painter, bool foregrounds) {
                           ->Data(FieldPath::Of<Room::Background>(FieldPath::StartingAt(row),
                                                                  Room::Background::kForegroundFieldNumber))
                           .toBool();
-    QString bkgName = backgrounds
-                          ->Data(FieldPath::Of<Room::Background>(FieldPath::StartingAt(row),
-                                                                 Room::Background::kBackgroundNameFieldNumber))
-                          .toString();
 
     if (!visible || foreground != foregrounds) continue;
-    MessageModel* bkgRes = MainWindow::resourceMap->GetResourceByName(TreeNode::kBackground, bkgName);
-    if (!bkgRes) continue;
-    bkgRes = bkgRes->GetSubModel<MessageModel*>(TreeNode::kBackgroundFieldNumber);
+    MessageModel* bkgRes = _roomBackgrounds->ResourceAt(row);
     if (!bkgRes) continue;
 
     int x =
@@ -154,8 +162,11 @@ void RoomView::paintBackgrounds(QPainter& painter, bool foregrounds) {
     int h = bkgRes->Data(FieldPath::Of<Background>(Background::kHeightFieldNumber)).toInt();
 
     QString imgFile = bkgRes->Data(FieldPath::Of<Background>(Background::kImageFieldNumber)).toString();
-    QPixmap pixmap = ArtManager::GetCachedPixmap(imgFile);
-    if (pixmap.isNull()) continue;
+    QPixmap pixmap = ArtManager::FindCachedPixmap(imgFile);
+    if (pixmap.isNull()) {
+      _awaitedImages.insert(imgFile);
+      continue;
+    }
 
     QRectF dest(x, y, w, h);
     QRectF src(0, 0, w, h);
@@ -199,30 +210,17 @@ void RoomView::paintBackgrounds(QPainter& painter, bool foregrounds) {
 }
 
 void RoomView::paintInstances(QPainter& painter) {
+  ObjectSpriteCache* sprites = MainWindow::resourceMap->ObjectSprites();
   for (int row = 0; row < _sortedInstances->rowCount(); row++) {
-    QString imgFile = ":/actions/help.png";
-    int w = 16;
-    int h = 16;
-    int xoff = 0;
-    int yoff = 0;
-
-    QVariant sprName = _sortedInstances->Data(
-        FieldPath::Of<Room::Instance>(FieldPath::StartingAt(row), Room::Instance::kObjectTypeFieldNumber));
-
-    MessageModel* spr = GetObjectSprite(sprName.toString());
-    if (spr == nullptr || spr->GetSubModel<RepeatedStringModel*>(Sprite::kSubimagesFieldNumber)->Empty()) {
-      imgFile = "object";
-    } else {
-      imgFile =
-          spr->Data(FieldPath::Of<Sprite>(FieldPath::RepeatedOffset(Sprite::kSubimagesFieldNumber, 0))).toString();
-      w = spr->Data(FieldPath::Of<Sprite>(Sprite::kWidthFieldNumber)).toInt();
-      h = spr->Data(FieldPath::Of<Sprite>(Sprite::kHeightFieldNumber)).toInt();
-      xoff = spr->Data(FieldPath::Of<Sprite>(Sprite::kOriginXFieldNumber)).toInt();
-      yoff = spr->Data(FieldPath::Of<Sprite>(Sprite::kOriginYFieldNumber)).toInt();
+    const ObjectSpriteCache::Entry& sprite =
+        sprites->Resolve(_sortedInstances->Objects()->IdAt(_sortedInstances->SourceRow(row)));
+    const QPixmap& pixmap = sprite.pixmap;
+    if (pixmap.isNull()) {
+      _awaitedImages.insert(sprite.image);
+      continue;
     }
-
-    QPixmap pixmap = ArtManager::GetCachedPixmap(imgFile);
-    if (pixmap.isNull()) continue;
+    const int w = sprite.width, h = sprite.height;
+    const int xoff = sprite.originX, yoff = sprite.originY;
 
     QVariant x = _sortedInstances->Data(
         FieldPath::Of<Room::Instance>(FieldPath::StartingAt(row), Room::Instance::kXFieldNumber));
@@ -4,11 +4,20 @@
 #include "AssetView.h"
 #include "Models/MessageModel.h"
 #include "Models/RepeatedSortFilterProxyModel.h"
+#include "Models/ResourceIdColumn.h"
+
+#include <QSet>
 
 class InstanceSortFilterProxyModel : public RepeatedSortFilterProxyModel {
  public:
-  InstanceSortFilterProxyModel(QObject *parent) : RepeatedSortFilterProxyModel(parent) {}
+  InstanceSortFilterProxyModel(QObject *parent);
+  void SetSourceModel(RepeatedModel *sourceModel) override;
   bool lessThan(const QModelIndex& left, const QModelIndex& right) const override;
+  // The object of each instance, by source row.
+  const ResourceIdColumn *Objects() const { return _objects; }
+
+ private:
+  ResourceIdColumn *_objects;
 };
 
 class RoomView : public AssetView {
@@ -24,7 +33,10 @@ class RoomView : public AssetView {
   MessageModel *_model;
   InstanceSortFilterProxyModel *_sortedInstances;
   RepeatedSortFilterProxyModel *_sortedTiles;
+  ResourceIdColumn *_tileBackgrounds;  // By source row of _sortedTiles.
+  ResourceIdColumn *_roomBackgrounds;
   QPixmap _transparentPixmap;
+  QSet<QString> _awaitedImages;  // Images the last paint skipped because they weren't decoded yet.
 
   void paintTiles(QPainter &painter);
   void paintBackgrounds(QPainter &painter, bool foregrounds = false);
@@ -14,6 +14,10 @@ QSize SpriteView::sizeHint() const { return _pixmap.size(); }
 void SpriteView::SetResourceModel(MessageModel *model) {
   _model = model;
   _subimgs = _model->GetSubModel<RepeatedStringModel *>(Sprite::kSubimagesFieldNumber);
+  // Decode every subimage up front, so stepping through them doesn't wait on the disk.
+  QStringList subimages;
+  for (int i = 0; i < _subimgs->rowCount(); ++i) subimages.append(_subimgs->DataAtRow(i).toString());
+  ArtManager::PrefetchPixmaps(subimages);
   if (_subimgs->rowCount() > 0) SetSubimage(0);
 }
 